@@ -0,0 +1,3 @@
+g++ -std=c++20 -O2 $(ls ../src/*.cpp | grep -v main.cpp) ../tools/StickBenchmark.cpp -o ../bin/StickBenchmark -I../lib/MAC/sfml/2.6.0/include -L../lib/MAC/sfml/2.6.0/lib/ -lsfml-window -lsfml-graphics -lsfml-network -lsfml-system -lsfml-audio
+
+../bin/StickBenchmark
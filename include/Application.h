@@ -5,6 +5,7 @@
 #include "gui/Button.h"
 
 #include "GuiHandler.h"
+#include "ControlHandler.h"
 #include <iostream>
 #include <vector>
 #include <sstream>
@@ -45,6 +46,7 @@ class Application
 
         pe::Simulation m_sim;
         handler::GuiHandler m_guiHandler;
+        handler::ControlHandler m_controlHandler;
 
         sf::Clock m_updateClock;
 
@@ -0,0 +1,128 @@
+#ifndef COLLISIONGRID_H
+#define COLLISIONGRID_H
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include "ParticleStore.h"
+
+namespace pe {
+
+    // uniform grid used as the broadphase for ball collisions
+    // cells are at least as wide as the biggest ball, so two touching balls are
+    // always in the same cell or in neighbouring cells
+    class CollisionGrid
+    {
+        private:
+            float m_cellSize = 16.f;
+            float m_invCellSize = 1.f / 16.f;
+            int m_columns = 0;
+            int m_rows = 0;
+
+            // object indices sorted by cell, cell c owns m_cellObjects[m_cellStart[c]] .. m_cellObjects[m_cellStart[c+1]]
+            std::vector<int> m_cellStart;
+            std::vector<int> m_cellCursor;
+            std::vector<int> m_cellObjects;
+            std::vector<int> m_objectCell;
+
+            static const int s_maxCells = 1 << 20;
+
+        private:
+            static int toCell( float cell, int cellCount );
+            int getCellX( float x ) const;
+            int getCellY( float y ) const;
+
+            void setCellSize( float cellSize, float width, float height );
+            template<typename IndexFn>
+            void sortIntoCells( const ParticleStore& particles, std::size_t count, IndexFn indexAt );
+
+            template<typename F>
+            void forEachPairInCells( int cellA, int cellB, F& func ) const
+            {
+                for(int a = m_cellStart[cellA]; a < m_cellStart[cellA + 1]; ++a)
+                {
+                    for(int b = m_cellStart[cellB]; b < m_cellStart[cellB + 1]; ++b)
+                    {
+                        func(m_cellObjects[a], m_cellObjects[b]);
+                    }
+                }
+            }
+
+        public:
+            // sorts every particle into the grid, the grid covers width x height and
+            // positions outside of it are clamped to the border cells
+            // margin widens the cells so pairs up to margin apart are still found in neighbouring cells
+            void build( const ParticleStore& particles, float width, float height, float margin = 0.f );
+            // only sorts the particles at the given indices, cellSize must be at least the biggest diameter among them
+            void build( const ParticleStore& particles, const std::vector<int>& indices, float cellSize, float width, float height );
+
+            // calls func(index1, index2) once for every pair of objects in neighbouring cells,
+            // only looking at cells in the columns [colBegin, colEnd)
+            // pairs found from a column only touch objects in that column and the ones either side of it
+            template<typename F>
+            void forEachPairInColumns( int colBegin, int colEnd, F&& func ) const
+            {
+                for(int x = colBegin; x < colEnd; ++x)
+                {
+                    for(int y = 0; y < m_rows; ++y)
+                    {
+                        int cell = x * m_rows + y;
+
+                        // pairs inside the same cell
+                        for(int a = m_cellStart[cell]; a < m_cellStart[cell + 1]; ++a)
+                        {
+                            for(int b = a + 1; b < m_cellStart[cell + 1]; ++b)
+                            {
+                                func(m_cellObjects[a], m_cellObjects[b]);
+                            }
+                        }
+
+                        // only half of the neighbours are checked so each pair of cells is visited once
+                        if(x + 1 < m_columns)
+                            forEachPairInCells(cell, cell + m_rows, func);
+                        if(y + 1 < m_rows)
+                        {
+                            forEachPairInCells(cell, cell + 1, func);
+                            if(x > 0)
+                                forEachPairInCells(cell, cell - m_rows + 1, func);
+                            if(x + 1 < m_columns)
+                                forEachPairInCells(cell, cell + m_rows + 1, func);
+                        }
+                    }
+                }
+            }
+
+            template<typename F>
+            void forEachPair( F&& func ) const
+            {
+                forEachPairInColumns(0, m_columns, func);
+            }
+
+            // calls func(index) for every object in the 3x3 cells around (x, y)
+            template<typename F>
+            void forEachNear( float x, float y, F&& func ) const
+            {
+                int cx = getCellX(x);
+                int cy = getCellY(y);
+                for(int col = std::max(cx - 1, 0); col <= std::min(cx + 1, m_columns - 1); ++col)
+                {
+                    for(int row = std::max(cy - 1, 0); row <= std::min(cy + 1, m_rows - 1); ++row)
+                    {
+                        int cell = col * m_rows + row;
+                        for(int a = m_cellStart[cell]; a < m_cellStart[cell + 1]; ++a)
+                            func(m_cellObjects[a]);
+                    }
+                }
+            }
+
+            const bool isEmpty( ) const;
+
+            const float getCellSize( ) const;
+            const int getColumns( ) const;
+            const int getRows( ) const;
+    };
+
+};
+
+#endif //!COLLISIONGRID_H
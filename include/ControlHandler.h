@@ -0,0 +1,32 @@
+#ifndef CONTROLHANDLER_H
+#define CONTROLHANDLER_H
+#pragma once
+#include "Simulation.h"
+#include "SimCommand.h"
+#include "InputHandler.h"
+
+namespace handler {
+
+    // reads the keyboard and mouse on the window thread and hands them to the simulation, as commands for
+    // anything that happens once and as frame input for buttons that are held, so it never looks at the input itself
+    class ControlHandler
+    {
+        private:
+            pe::Simulation* m_sim = nullptr;
+
+            bool m_isKeyHeld = false;
+            bool m_isMouseHeld = false;
+            bool m_buildKeyHeld = false;
+
+        private:
+            void buildModeControls( sf::Vector2f mousePos, bool stickFinished );
+            void keyControls( );
+
+        public:
+            ControlHandler( pe::Simulation& sim );
+            void update( sf::Vector2f mousePos, bool hasFocus );
+    };
+};
+
+
+#endif //!CONTROLHANDLER_H
@@ -0,0 +1,64 @@
+#ifndef HIERARCHICALGRID_H
+#define HIERARCHICALGRID_H
+#pragma once
+#include <vector>
+
+#include "CollisionGrid.h"
+#include "ParticleStore.h"
+
+namespace pe {
+
+    // broadphase for scenes with very different ball sizes
+    // every level is a uniform grid with cells twice as wide as the level below it, and each ball
+    // goes into the smallest level its diameter fits in, so a few huge balls don't make the cells huge for everything else
+    class HierarchicalGrid
+    {
+        private:
+            std::vector<CollisionGrid> m_levels;
+            std::vector<std::vector<int>> m_levelObjects;
+            std::vector<std::vector<float>> m_levelX;
+            std::vector<std::vector<float>> m_levelY;
+
+            float m_baseCellSize = 2.f;
+
+            static const int s_maxLevels = 16;
+
+        public:
+            void build( const ParticleStore& particles, float width, float height );
+
+            // calls func(index1, index2) once for every pair of objects that could be touching
+            template<typename F>
+            void forEachPair( F&& func ) const
+            {
+                for(std::size_t level = 0; level < m_levels.size(); ++level)
+                {
+                    if(m_levelObjects[level].empty())
+                        continue;
+
+                    m_levels[level].forEachPair(func);
+
+                    // balls are only ever tested against the same or bigger levels, the bigger level's cells are
+                    // wide enough that anything touching a ball is in the 3x3 cells around its centre
+                    for(std::size_t other = level + 1; other < m_levels.size(); ++other)
+                    {
+                        if(m_levelObjects[other].empty())
+                            continue;
+
+                        for(std::size_t k = 0; k < m_levelObjects[level].size(); ++k)
+                        {
+                            int index = m_levelObjects[level][k];
+                            m_levels[other].forEachNear(m_levelX[level][k], m_levelY[level][k], [&func, index](int otherIndex){
+                                func(index, otherIndex);
+                            });
+                        }
+                    }
+                }
+            }
+
+            const int getLevelCount( ) const;
+            const std::size_t getLevelSize( int level ) const;
+    };
+
+};
+
+#endif //!HIERARCHICALGRID_H
@@ -1,7 +1,10 @@
 #ifndef IDVECTOR_H
 #define IDVECTOR_H
+#include <algorithm>
 #include <cstddef>
+#include <deque>
 #include <iterator>
+#include <stdexcept>
 #include <strings.h>
 #include <utility>
 #include <vector>
@@ -11,23 +14,84 @@ template<typename T>
 class IDVector
 {
     private:
+        // every ID points at a slot, the slot holds the element's current index in m_container
+        // the slot's generation is stored in the ID's upper bits, it changes when the element is deleted
+        // so an old ID for a reused slot doesn't find the new element
+        struct Slot
+        {
+            int index;
+            int generation;
+        };
+
         std::vector<T> m_container;
-        int counterID;
+        std::vector<Slot> m_slots;
+        // oldest freed slots get reused first so generations wrap as late as possible
+        std::deque<int> m_freeSlots;
+
+        // when set, deleting moves the last element into the hole instead of shifting everything after it down
+        bool m_unorderedDelete = false;
+
+        // ids are the slot in the low bits and the generation above it, so at most 1 << s_slotBits elements
+        // (about a million) can be alive at once, any more and a new slot would alias slot 0
+        static const int s_slotBits = 20;
+        static const int s_maxSlots = 1 << s_slotBits;
+        static const int s_slotMask = (1 << s_slotBits) - 1;
+        static const int s_generationMask = (1 << (31 - s_slotBits)) - 1;
+
     private:
+        static int slotOf( int id )
+        {
+            return id & s_slotMask;
+        }
+
+        static int generationOf( int id )
+        {
+            return (id >> s_slotBits) & s_generationMask;
+        }
+
+        int allocateSlot( )
+        {
+            if(!m_freeSlots.empty())
+            {
+                int slot = m_freeSlots.front();
+                m_freeSlots.pop_front();
+                return slot;
+            }
+            if(m_slots.size() >= static_cast<std::size_t>(s_maxSlots))
+                throw std::length_error("IDVECTOR IS OUT OF IDS");
+            m_slots.push_back({ -1, 0 });
+            return static_cast<int>(m_slots.size()) - 1;
+        }
+
+        void freeSlot( int id )
+        {
+            Slot& slot = m_slots[slotOf(id)];
+            slot.index = -1;
+            slot.generation = (slot.generation + 1) & s_generationMask;
+            m_freeSlots.push_back(slotOf(id));
+        }
+
+        // keeps the slots pointing at the right place after elements from 'from' onwards have moved
+        void fixIndicesFrom( std::size_t from )
+        {
+            for(std::size_t i = from; i < m_container.size(); ++i)
+                m_slots[slotOf(m_container[i].ID)].index = static_cast<int>(i);
+        }
 
     public:
         using iterator = typename std::vector<T>::iterator;
         using const_iterator = typename std::vector<T>::const_iterator;
 
     public:
-        IDVector( ) : counterID{ 0 } {}
+        IDVector( ) {}
 
         template<typename... Args>
         T& emplaceBack( Args&&... args )
         {
-            T& returnValue = m_container.emplace_back(counterID, std::forward<Args>(args)...);
-            counterID ++;
-            return returnValue;
+            int slot = allocateSlot();
+            int id = (m_slots[slot].generation << s_slotBits) | slot;
+            m_slots[slot].index = static_cast<int>(m_container.size());
+            return m_container.emplace_back(id, std::forward<Args>(args)...);
         }
 
         void reserve( int value )
@@ -35,18 +99,71 @@ class IDVector
             m_container.reserve(value);
         }
 
+        void setUnorderedDelete( bool unordered )
+        {
+            m_unorderedDelete = unordered;
+        }
+
         void deleteElementById( int& id )
         {
-            for(auto it = m_container.begin(); it != m_container.end(); ++it)
+            int index = findIndexById(id);
+            if(index == -1)
+                return;
+
+            freeSlot(id);
+            if(m_unorderedDelete)
             {
-                if(it->ID == id)
+                // swap and pop, only the moved element's slot needs updating
+                std::size_t last = m_container.size() - 1;
+                if(static_cast<std::size_t>(index) != last)
                 {
-                    m_container.erase(it);
-                    break;
+                    m_container[index] = std::move(m_container[last]);
+                    m_slots[slotOf(m_container[index].ID)].index = index;
                 }
+                m_container.pop_back();
+            }
+            else
+            {
+                m_container.erase(m_container.begin() + index);
+                fixIndicesFrom(static_cast<std::size_t>(index));
             }
         }
 
+        // deletes all of the given IDs at once, unknown or repeated IDs are ignored
+        void deleteElementsByIds( const std::vector<int>& ids )
+        {
+            if(m_unorderedDelete)
+            {
+                for(int id : ids)
+                    deleteElementById(id);
+                return;
+            }
+
+            std::size_t first = m_container.size();
+            for(int id : ids)
+            {
+                int index = findIndexById(id);
+                if(index == -1)
+                    continue;
+                freeSlot(id);
+                first = std::min(first, static_cast<std::size_t>(index));
+            }
+
+            // a freed element's slot no longer points back at it, everything else is kept in order in a single pass
+            std::size_t write = first;
+            for(std::size_t read = first; read < m_container.size(); ++read)
+            {
+                const Slot& slot = m_slots[slotOf(m_container[read].ID)];
+                if(slot.index == -1 || slot.generation != generationOf(m_container[read].ID))
+                    continue;
+                if(write != read)
+                    m_container[write] = std::move(m_container[read]);
+                write++;
+            }
+            m_container.erase(m_container.begin() + write, m_container.end());
+            fixIndicesFrom(first);
+        }
+
         std::size_t size( )
         {
             return m_container.size();
@@ -57,16 +174,20 @@ class IDVector
             return m_container[index];
         }
 
+        // O(1), returns -1 for IDs that were never handed out or whose element has been deleted
         int findIndexById( int id )
         {
-            for(std::size_t i = 0; i < m_container.size(); ++i)
-            {
-                if(m_container[i].ID == id)
-                {
-                    return static_cast<int>(i);
-                }
-            }
-            return -1;
+            int slot = slotOf(id);
+            if(id < 0 || slot >= static_cast<int>(m_slots.size()))
+                return -1;
+            if(m_slots[slot].generation != generationOf(id))
+                return -1;
+            return m_slots[slot].index;
+        }
+
+        bool contains( int id )
+        {
+            return findIndexById(id) != -1;
         }
 
         T& getById( int id )
@@ -81,12 +202,18 @@ class IDVector
 
         void clear( )
         {
+            for(auto& element : m_container)
+                freeSlot(element.ID);
             m_container.clear();
         }
 
         iterator erase( iterator pos )
         {
-            return m_container.erase(pos);
+            std::size_t index = static_cast<std::size_t>(pos - m_container.begin());
+            freeSlot(pos->ID);
+            iterator next = m_container.erase(pos);
+            fixIndicesFrom(index);
+            return next;
         }
 
 
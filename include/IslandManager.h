@@ -0,0 +1,47 @@
+#ifndef ISLANDMANAGER_H
+#define ISLANDMANAGER_H
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace pe {
+
+    // union-find over object indices, objects joined by a stick (or a contact) end up in the same island
+    // joining is incremental, but a join can't be taken back, so deleting an object or stick means a reset
+    // and joining everything again
+    class IslandManager
+    {
+        private:
+            std::vector<int> m_parent;
+            std::vector<int> m_size;
+
+            // filled in by group(), island k is m_objects[m_start[k]] .. m_objects[m_start[k+1]]
+            std::vector<int> m_islandOf;
+            std::vector<int> m_objects;
+            std::vector<int> m_start = { 0 };
+            int m_largestIsland = 0;
+            bool m_grouped = false;
+
+        public:
+            // every object starts on its own
+            void reset( std::size_t objectCount );
+            void addObject( );
+            void join( int a, int b );
+            int find( int a );
+
+            // sorts the objects by island, the getters below are only valid after this
+            void group( );
+            const bool isGrouped( ) const;
+
+            const std::size_t getObjectCount( ) const;
+            const int getIslandCount( ) const;
+            const int getIslandBegin( int island ) const;
+            const int getIslandEnd( int island ) const;
+            const std::vector<int>& getIslandObjects( ) const;
+            const int getIsland( int object ) const;
+            const int getLargestIslandSize( ) const;
+    };
+
+};
+
+#endif //!ISLANDMANAGER_H
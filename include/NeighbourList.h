@@ -0,0 +1,60 @@
+#ifndef NEIGHBOURLIST_H
+#define NEIGHBOURLIST_H
+#pragma once
+#include <vector>
+
+#include "CollisionGrid.h"
+#include "ParticleStore.h"
+
+namespace pe {
+
+    // verlet neighbour lists, every ball keeps a list of the balls within its radius plus a skin distance
+    // the lists only need rebuilding once something has moved more than half the skin, until then
+    // the substeps just walk the lists instead of searching the grid again
+    class NeighbourList
+    {
+        private:
+            CollisionGrid m_grid;
+
+            // neighbours of object i are m_neighbours[m_start[i]] .. m_neighbours[m_start[i+1]], only ones with a higher index
+            std::vector<int> m_start;
+            std::vector<int> m_neighbours;
+            std::vector<std::pair<int, int>> m_pairs;
+
+            // where everything was when the lists were built
+            std::vector<float> m_buildX;
+            std::vector<float> m_buildY;
+            std::vector<float> m_buildRadii;
+
+            float m_skin = 4.f;
+            unsigned int m_topologyVersion = 0;
+            bool m_built = false;
+            int m_rebuildCount = 0;
+
+        private:
+            bool needsRebuild( const ParticleStore& particles, unsigned int topologyVersion ) const;
+            void rebuild( const ParticleStore& particles, float width, float height );
+
+        public:
+            // rebuilds the lists if anything moved too far, was resized, added or deleted
+            void update( const ParticleStore& particles, float width, float height, unsigned int topologyVersion );
+
+            template<typename F>
+            void forEachPair( F&& func ) const
+            {
+                for(std::size_t i = 0; i + 1 < m_start.size(); ++i)
+                {
+                    for(int k = m_start[i]; k < m_start[i + 1]; ++k)
+                        func(static_cast<int>(i), m_neighbours[k]);
+                }
+            }
+
+            void setSkin( float skin );
+            const float getSkin( ) const;
+            // how many times the lists have been rebuilt since the last call
+            int takeRebuildCount( );
+    };
+
+};
+
+#endif //!NEIGHBOURLIST_H
@@ -9,6 +9,8 @@ struct Object
 {
     sf::Vector2f currentPos;
     sf::Vector2f oldPos;
+    // where it was at the start of the last physics tick, rendering blends from here to currentPos
+    sf::Vector2f previousPos;
     sf::Vector2f acceleration;
 
     sf::Color color = sf::Color::White;
@@ -22,6 +24,10 @@ struct Object
     bool isPinned = false;
     bool isGrabbed = false;
     bool isSelected = false;
+    // asleep objects aren't integrated and don't collide with each other, see Simulation::updateSleeping
+    bool isSleeping = false;
+    // ticks in a row this has barely moved for
+    int stillTicks = 0;
 
     float bounceAmount = 0.5f;
 
@@ -0,0 +1,74 @@
+#ifndef PARTICLESTORE_H
+#define PARTICLESTORE_H
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "IDVector.h"
+#include "Object.h"
+
+namespace pe {
+
+    // the hot part of every Object split into flat arrays, index i is m_objects[i]
+    // the simulation gathers the objects into this at the start of a frame, runs all of the substeps on the
+    // arrays and scatters the positions back afterwards, so input, gui and rendering keep using Object&
+    struct ParticleStore
+    {
+        enum Flags : std::uint8_t
+        {
+            PINNED = 1 << 0,
+            GRABBED = 1 << 1,
+            SLEEPING = 1 << 2,
+            // was asleep and got pushed this tick, its still count starts again from 0
+            WOKEN = 1 << 3,
+            // the integrator leaves these where they are
+            FIXED = PINNED | SLEEPING
+        };
+
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> oldX;
+        std::vector<float> oldY;
+        // position at the start of the last tick, see Object::previousPos
+        std::vector<float> prevX;
+        std::vector<float> prevY;
+        std::vector<float> accX;
+        std::vector<float> accY;
+        std::vector<float> radius;
+        std::vector<float> mass;
+        std::vector<std::uint8_t> flags;
+        // a sleeping ball pushed by less than this stays asleep and where it is, a settled neighbour nudging it
+        // back every substep would otherwise keep waking it and no pile would ever sleep
+        float wakeDistance = 0.f;
+
+        std::size_t size( ) const { return x.size(); }
+        bool isPinned( std::size_t i ) const { return flags[i] & PINNED; }
+        bool isGrabbed( std::size_t i ) const { return flags[i] & GRABBED; }
+        bool isSleeping( std::size_t i ) const { return flags[i] & SLEEPING; }
+        // sleeping pairs have settled against each other, there's nothing to solve between them
+        bool areBothSleeping( std::size_t i, std::size_t j ) const { return flags[i] & flags[j] & SLEEPING; }
+        bool wasWoken( std::size_t i ) const { return flags[i] & WOKEN; }
+        // no branch, a sleeping ball's SLEEPING bit moves up into WOKEN and an awake ball is left alone
+        void wake( std::size_t i ) { flags[i] = (flags[i] & ~SLEEPING) | ((flags[i] & SLEEPING) << 1); }
+        // true if the ball can be moved by the push, a sleeping ball is only woken if it's pushed hard enough
+        bool wakeByPush( std::size_t i, float offsetX, float offsetY )
+        {
+            if(!(flags[i] & SLEEPING))
+                return true;
+            if(offsetX * offsetX + offsetY * offsetY <= wakeDistance * wakeDistance)
+                return false;
+            wake(i);
+            return true;
+        }
+
+        void gather( IDVector<Object>& objects );
+        // remembers where everything is before a tick moves it
+        void beginTick( );
+        // only writes back what the substeps change, the positions, accelerations and sleeping
+        void scatter( IDVector<Object>& objects ) const;
+    };
+
+};
+
+#endif //!PARTICLESTORE_H
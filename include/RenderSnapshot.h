@@ -0,0 +1,72 @@
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "StickMaker.h"
+
+namespace pe {
+
+    // everything the renderer needs from one finished simulation frame, copied out so the simulation
+    // thread can carry on while it's drawn
+    struct RenderSnapshot
+    {
+        struct Ball
+        {
+            sf::Vector2f previousPos;
+            sf::Vector2f currentPos;
+            float radius;
+            sf::Color color;
+            sf::Color outlineColor;
+            int outlineThic;
+            bool isPinned;
+        };
+
+        // indices into balls
+        struct Stick
+        {
+            int ball1;
+            int ball2;
+        };
+
+        std::vector<Ball> balls;
+        std::vector<Stick> sticks;
+
+        std::vector<Builder::BluePrintStick> bluePrintSticks;
+        bool showBluePrints = false;
+
+        sf::Vector2f mousePos;
+        float mouseColRadius = 0.f;
+        bool showMouseCollider = false;
+        sf::Color mouseColColor;
+
+        // the controls need these to know which keys mean what
+        bool buildModeActive = false;
+        bool stickFinished = true;
+
+        std::string debugText;
+
+        // the renderer works out its own alpha from these, the frame is drawn later than it was published
+        bool fixedTimestep = false;
+        float accumulator = 0.f;
+        float tickTime = 1.f;
+        std::chrono::steady_clock::time_point publishedAt;
+    };
+
+    // what the simulation needs from the window each frame, so it never has to touch the window itself
+    struct FrameInput
+    {
+        sf::Vector2f mousePos;
+        bool hasFocus = false;
+        // buttons that do something for as long as they're held, sent as state so a full command queue can't lose them
+        bool leftHeld = false;
+        bool rightHeld = false;
+        bool chainHeld = false;
+    };
+
+};
+
+#endif //!RENDERSNAPSHOT_H
@@ -0,0 +1,48 @@
+#ifndef SIMCOMMAND_H
+#define SIMCOMMAND_H
+#pragma once
+#include "SFML/System/Vector2.hpp"
+
+namespace pe {
+
+    // a change to the scene asked for from outside the simulation thread, the simulation carries these out
+    // itself at the start of its next frame so nothing else ever touches the objects or sticks
+    // grabbing, spawning and the mouse collider last as long as a button is held, so they come through FrameInput
+    struct SimCommand
+    {
+        enum Type
+        {
+            DELETE_BALL,
+            // turns the blue prints into balls and sticks
+            FINISH_STICK,
+            // picks the ball under position as one end of a new stick
+            JOIN,
+            CLEAR,
+            TOGGLE_PAUSE,
+            TOGGLE_GRAVITY,
+            TOGGLE_BUILD,
+            // pins or unpins the grabbed ball, in build mode it toggles whether new balls are pinned
+            TOGGLE_PIN,
+            // grows or shrinks the mouse collider or the grabbed ball by amount
+            CHANGE_MOUSE_RADIUS,
+            // position is the new width and height
+            SET_BOUNDS,
+            ZERO_VELOCITIES
+        };
+
+        Type type = CLEAR;
+        sf::Vector2f position;
+        float amount = 0.f;
+
+        SimCommand( ) = default;
+        SimCommand( Type type, sf::Vector2f position = { 0.f, 0.f }, float amount = 0.f )
+            : type { type }
+            , position { position }
+            , amount { amount }
+        {
+        }
+    };
+
+};
+
+#endif //!SIMCOMMAND_H
@@ -0,0 +1,56 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+#pragma once
+
+#include "ParticleStore.h"
+#include "Stick.h"
+
+namespace pe {
+
+    // a fixed width block of candidate pairs from the broadphase, solved together by the narrow phase
+    struct PairBlock
+    {
+        static const int SIZE = 8;
+        int first[SIZE];
+        int second[SIZE];
+        int count = 0;
+    };
+
+    // vectorised versions of the hot loops, picked at runtime from what the cpu supports
+    // every kernel has a scalar version, which is also what non x86 machines use
+    struct SimdKernels
+    {
+        enum Level
+        {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        // the best level this cpu can run
+        static Level getSupportedLevel( );
+        static bool supportsFma( );
+        static const char* getLevelName( Level level );
+
+        // verlet step for every particle that isn't pinned or asleep, those are masked out rather than branched on
+        // without fma the result is bit for bit the same as the scalar loop, strict mode is just useFma = false
+        static void integrate( ParticleStore& particles, float subDeltaTime, Level level, bool useFma );
+
+        // circle-circle collisions for a block of pairs, pairs that don't overlap are rejected on squared distances
+        // before any square root, overlaps are pushed apart the same way as Simulation::solveCollision
+        // every pair in the block is worked out from the positions at the start of the block, so no ball may be in
+        // the block twice or its pushes would add up instead of the second one seeing where the first left it
+        // a sleeping ball that gets pushed is woken, so blocks must not have pairs that are both asleep
+        // strict uses a real square root everywhere, so the result is the same as the scalar version on any cpu
+        static void solveCollisionBlock( ParticleStore& particles, PairBlock& block, Level level, bool strict );
+
+        // the xpbd step every stick would take if it was solved on its own, nothing is written to the particles
+        // so any number of these can run over the same positions at once, index1 moves by -offset * invMass1
+        // and index2 by +offset * invMass2, each stick's lambda is updated
+        static void stickCorrections( const ParticleStore& particles, CompiledStick* sticks, std::size_t count,
+                                      float invSubDeltaTimeSq, float* offsetX, float* offsetY, Level level );
+    };
+
+};
+
+#endif //!SIMDKERNELS_H
@@ -4,13 +4,19 @@
 #include <_types/_uint8_t.h>
 #include <SFML/Graphics.hpp>
 #include <cstddef>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include <list>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
 #include <iostream>
 #include <cmath>
 #include <sstream>
+#include <random>
 
 #include "IDVector.h"
 #include "Global.h"
@@ -26,10 +32,67 @@
 #include "Math.h"
 #include "ColorHandler.h"
 #include "gui/Button.h"
+#include "CollisionGrid.h"
+#include "HierarchicalGrid.h"
+#include "ThreadPool.h"
+#include "SweepAndPrune.h"
+#include "NeighbourList.h"
+#include "ParticleStore.h"
+#include "SimdKernels.h"
+#include "StickColouring.h"
+#include "IslandManager.h"
+#include "TripleBuffer.h"
+#include "RenderSnapshot.h"
+#include "SpscQueue.h"
+#include "SimCommand.h"
 
 using namespace mth;
 namespace pe {
 
+    // how checkCollisions finds the pairs of balls to test
+    enum class BroadPhase
+    {
+        ALL_PAIRS,
+        UNIFORM_GRID,
+        HIERARCHICAL_GRID,
+        SWEEP_AND_PRUNE,
+        NEIGHBOUR_LIST
+    };
+
+    // how updateSticks solves the compiled sticks
+    enum class StickSolver
+    {
+        // one after another in the order they were added
+        SEQUENTIAL,
+        // graph coloured, every colour is solved in parallel
+        COLOURED_PARALLEL,
+        // every stick works from the same positions and takes a share of its step that keeps any ball from
+        // overshooting, converges slower but the whole pass is data parallel
+        JACOBI,
+        // islands that aren't joined by any stick are solved in parallel, each one in order
+        ISLAND_PARALLEL
+    };
+
+    // how render draws the balls and pin markers
+    enum class RenderMode
+    {
+        // one sf::CircleShape draw call per ball and per pin
+        SHAPES,
+        // every circle built out of triangles into one vertex array and drawn in one call
+        TRIANGLES,
+        // one quad per circle over an anti-aliased circle texture, tinted by the vertex colour, also one call
+        TEXTURED_QUADS
+    };
+
+    // how many times each constraint phase runs inside one substep, so a cheap phase can be repeated
+    // without also repeating the expensive ones
+    struct SolverSchedule
+    {
+        int stickIterations = 1;
+        int collisionIterations = 1;
+        int boundaryIterations = 1;
+    };
+
     class Simulation
     {
         private:
@@ -37,7 +100,10 @@ namespace pe {
 
 
             int m_subStepNumber;
+            SolverSchedule m_schedule;
             float m_deltaTime;
+            // wall time the last frame took, in seconds
+            float m_frameTime = 0.f;
             float m_subDeltaTime;
             float m_time;
 
@@ -48,6 +114,8 @@ namespace pe {
 
             sf::Clock m_clock;
             sf::Clock m_simUpdateClock;
+            // how long the last simulate call took, not counting the wait before the next one
+            float m_simFrameTime = 0.f;
 
 
 
@@ -57,12 +125,56 @@ namespace pe {
             sf::Clock m_deltaTimeClock;
             float MULT  = 60;
 
+            // fixed timestep, the frame time goes into the accumulator and whole ticks of 1 / m_tickRate come out
+            bool m_fixedTimestep = false;
+            float m_tickRate = 240.f;
+            // more ticks than this in one frame and the rest of the backlog is dropped, the sim runs slow instead
+            // of every frame taking longer than the one before
+            int m_maxTicksPerFrame = 8;
+            // without a fixed timestep there's nothing to wait for, so frames are capped to this rate instead
+            float m_maxFrameRate = 240.f;
+            float m_accumulator = 0.f;
+            // how far into the next tick the frame is, 0 .. 1, for interpolating the render
+            float m_alpha = 1.f;
+            int m_ticksThisFrame = 0;
+
+            // the simulation runs on m_updateThread once startSim is called, it gets the mouse and focus from the
+            // render thread through m_frameInput and hands every finished frame back through m_snapshots
             std::thread m_updateThread;
+            std::atomic<bool> m_simRunning { false };
+            // every change to the scene from the render thread comes through here, only the simulation thread pops
+            SpscQueue<SimCommand, 1024> m_commands;
+            // commands that didn't fit while the simulation was busy, render thread only, they go in before anything newer
+            std::deque<SimCommand> m_commandBacklog;
+            TripleBuffer<FrameInput> m_frameInput;
+            TripleBuffer<RenderSnapshot> m_snapshots;
+            // simulation thread's copy of the newest frame input
+            FrameInput m_input;
+            std::string m_debugString;
+            // render thread only
+            float m_renderAlpha = 1.f;
+            RenderMode m_renderMode = RenderMode::SHAPES;
+            // kept between frames so its memory is reused, only ever grows to the most vertices a frame has needed
+            sf::VertexArray m_ballVertices { sf::Triangles };
+            // cos and sin of every point on the circle, the same points sf::CircleShape uses
+            std::vector<sf::Vector2f> m_circlePoints;
+            sf::VertexArray m_ballQuads { sf::Quads };
+            // white circle on a transparent background, made the first time it's drawn since it needs the window's context
+            sf::Texture m_circleTexture;
+            static const int s_circleTextureSize = 256;
+            // every stick as a line, refilled each frame from the snapshot and drawn in one call
+            sf::VertexArray m_stickVertices { sf::Lines };
+            // if on and the driver has them, the lines go up as one streamed copy into a vertex buffer
+            bool m_stickVertexBuffer = false;
+            sf::VertexBuffer m_stickBuffer { sf::Lines, sf::VertexBuffer::Stream };
 
             // MOUSE
             sf::Vector2f m_mousePosView;
             sf::Vector2f m_mouseOldPos;
             sf::Vector2f m_mouseVelocity;
+            // throws were tuned with the mouse measured over one 244 fps render frame, the velocity is scaled to that
+            // so it doesn't change with how often the simulation runs
+            static constexpr float s_mouseThrowFrameTime = 1.f / 244.f;
             float m_mouseColRad = 15;
             bool m_mouseColActive = false;
             sf::CircleShape m_mouseColShape;
@@ -70,18 +182,13 @@ namespace pe {
             float m_mouseColMaxRad = 300;
             float m_mouseColMinRad = 1;
 
-
-            bool m_isKeyHeld = false;
-            bool m_isMouseHeld = false;
-            bool m_buildKeyHeld = false;
-
             bool m_gravityActive = true;
             bool m_paused = false;
 
             bool m_buildModeActive = false;
             bool m_newBallPin = false;
 
-            const int MAXBALLS = 1000;
+            const std::size_t MAXBALLS = 50000;
 
             sf::Clock m_spawnClock;
             float m_spawnNewBallDelay = 0.15;
@@ -89,6 +196,65 @@ namespace pe {
 
             IDVector<Object> m_objects;
             IDVector<Stick> m_sticks;
+            // the substeps run on this copy of m_objects, see ParticleStore
+            ParticleStore m_particles;
+
+            // picked at startup from what the cpu supports
+            SimdKernels::Level m_simdLevel = SimdKernels::SCALAR;
+            // keeps the vector kernels bit for bit the same as the scalar ones
+            bool m_strictMath = false;
+            // broadphase pairs go through SimdKernels::solveCollisionBlock instead of solveCollision one at a time
+            bool m_batchedNarrowPhase = true;
+            // object ID -> IDs of the sticks attached to it, so deleting an object only looks at its own sticks
+            std::unordered_map<int, std::vector<int>> m_objectSticks;
+
+            std::vector<CompiledStick> m_compiledSticks;
+            unsigned int m_compiledSticksVersion = 0;
+            bool m_sticksCompiled = false;
+
+            StickSolver m_stickSolver = StickSolver::SEQUENTIAL;
+            StickColouring m_stickColouring;
+            bool m_sticksColoured = false;
+            const int STICKS_PER_TASK = 512;
+
+            // jacobi scratch, per stick offsets and the per object sums they're averaged into
+            std::vector<float> m_stickOffsetX;
+            std::vector<float> m_stickOffsetY;
+            std::vector<float> m_jacobiDeltaX;
+            std::vector<float> m_jacobiDeltaY;
+            std::vector<int> m_jacobiCount;
+            // every stick's lambda before the pass, only the part of its step that was applied is kept
+            std::vector<float> m_jacobiLambda;
+
+            // compliance given to new sticks, see setStickCompliance
+            float m_stickCompliance = 0.f;
+            // 1 / subDeltaTime^2 for the substep being solved, turns compliance into the xpbd alpha
+            float m_stickInvSubDeltaTimeSq = 0.f;
+
+            // objects moving less than this per substep for m_sleepTicks ticks in a row go to sleep, with a fixed
+            // timestep that's a fixed time, otherwise it's however many frames
+            bool m_sleepingEnabled = true;
+            float m_sleepSpeed = 0.05f;
+            int m_sleepTicks = 60;
+            int m_sleepingCount = 0;
+
+            // objects joined by sticks, they go to sleep and wake up together and can be solved independently
+            // adding objects and sticks joins them in as they come, deleting anything needs a full rebuild
+            IslandManager m_islands;
+            bool m_islandsValid = false;
+
+            // compiled sticks sorted by island, each task solves a run of whole islands
+            std::vector<CompiledStick> m_islandSticks;
+            std::vector<int> m_islandStickTasks;
+            bool m_sticksIslanded = false;
+
+            // stick islands joined again by this substep's contacts, see checkCollisionsGridIslands
+            bool m_islandContacts = false;
+            IslandManager m_contactIslands;
+            std::vector<std::pair<int, int>> m_contactPairs;
+            std::vector<std::pair<int, int>> m_islandPairs;
+            std::vector<int> m_islandPairTasks;
+            const int CONTACTS_PER_TASK = 256;
 
             Builder::StickMaker m_stickMaker;
 
@@ -101,13 +267,34 @@ namespace pe {
             int m_constraintWidth = 100;
             int m_constraintHeight = 100;
 
+            BroadPhase m_broadPhase = BroadPhase::UNIFORM_GRID;
+            CollisionGrid m_grid;
+            HierarchicalGrid m_hierarchicalGrid;
+            SweepAndPrune m_sweepAndPrune;
+            NeighbourList m_neighbourList;
+
+            // bumped whenever objects or sticks are added, removed or pinned, cached structures rebuild when it changes
+            unsigned int m_topologyVersion = 0;
+
+            ThreadPool m_threadPool;
+            // below this the cost of waking the workers is more than the collisions themselves
+            const std::size_t MIN_PARALLEL_BALLS = 2000;
+
 
         private:
             void initText( );
 
             void updateObjects( float subDeltaTime );
-            void updateSticks( );
+            void updateSticks( float subDeltaTime );
+            void compileSticks( );
+            void resetStickLambdas( );
+            void solveStick( CompiledStick& stick );
+            void solveSticks( StickSolver solver );
+            void updateSticksColoured( );
+            void updateSticksJacobi( );
+            static const char* getStickSolverName( StickSolver solver );
             void updateText( );
+            const char* getBroadPhaseName( ) const;
             void updateMousePos( );
 
             void applyGravityToObjects( );
@@ -115,20 +302,56 @@ namespace pe {
             void checkConstraints( );
 
             void checkCollisions( );
+            void checkCollisionsAllPairs( );
+            void checkCollisionsGrid( );
+            void checkCollisionsGridParallel( );
+            void checkCollisionsGridIslands( );
+            void checkCollisionsHierarchicalGrid( );
+            void checkCollisionsSweepAndPrune( );
+            void checkCollisionsNeighbourList( );
+            void solveCollision( int i, int j );
+            void narrowPhase( PairBlock& block, int i, int j );
+            void flushNarrowPhase( PairBlock& block );
             void mouseCollisionsBall( );
-            void getInput( );
-
+            void executeCommands( );
+            void executeCommand( const SimCommand& command );
+            void flushCommands( );
+            // grabbing, spawning and the mouse collider, from the buttons held in m_input
+            void heldControls( );
+            void releaseGrabbed( );
+            void spawnBall( sf::Vector2f position );
+            void togglePin( );
+
+
+            void updateIslands( );
+            void updateSticksIslands( );
+            static void splitIntoTasks( const std::vector<int>& islandStart, int itemsPerTask, std::vector<int>& tasks );
+            void updateSleeping( );
+            void wakeAll( );
 
             void ballGrabbedMovement( );
+            void updateGrabbedOutline( );
 
-            bool mouseHoveringBall( );
-            bool mouseHoveringBall( int& deleteID );
+            bool mouseHoveringBall( sf::Vector2f position );
+            bool mouseHoveringBall( sf::Vector2f position, int& deleteID );
 
             void calcMouseVelocity( );
             void setDeltaTime( );
-
-            void nonBuildModeMouseControls();
-            void buildModeMouseControls();
+            void step( );
+            void simLoop( );
+            void publishSnapshot( );
+            // how far past the snapshot's last tick it is now, 0 .. 1
+            static float getRenderAlpha( const RenderSnapshot& snapshot );
+            // between previousPos and currentPos by the render alpha
+            const sf::Vector2f getRenderPosition( const RenderSnapshot::Ball& ball ) const;
+            void renderBallShapes( sf::RenderTarget& target, const RenderSnapshot& snapshot );
+            void renderBallTriangles( sf::RenderTarget& target, const RenderSnapshot& snapshot );
+            // both write from vertex onwards and move it past what they wrote
+            void addCircleTriangles( std::size_t& vertex, sf::Vector2f center, float radius, sf::Color color );
+            void addRingTriangles( std::size_t& vertex, sf::Vector2f center, float radius, float thickness, sf::Color color );
+            void renderBallQuads( sf::RenderTarget& target, const RenderSnapshot& snapshot );
+            void addCircleQuad( std::size_t& vertex, sf::Vector2f center, float radius, sf::Color color );
+            void initCircleTexture( );
 
         public:
 
@@ -142,25 +365,57 @@ namespace pe {
             void renderSticks( sf::RenderTarget& target );
             void renderUI( sf::RenderTarget& target );
             void renderBluePrints( sf::RenderTarget& target );
+            void setRenderMode( RenderMode mode );
+            void setStickVertexBuffer( bool enabled );
+            const RenderMode getRenderMode( ) const;
 
             void deleteBall( int& delID );
 
             void startSim( );
+            void stopSim( );
             void simulate( );
+            // runs a frame of exactly ticks ticks of 1 / tick rate, whatever the clock says, for tools that drive the
+            // simulation themselves instead of calling startSim
+            void advance( int ticks );
+            // called by the render thread every frame, the simulation picks up the newest one when its frame starts
+            void setFrameInput( const FrameInput& input );
+            // queues a change for the simulation thread, render thread only, if the queue is full it's kept and
+            // tried again on the next push or frame input
+            void pushCommand( const SimCommand& command );
+            // newest frame the simulation has finished, only call this from the render thread
+            const RenderSnapshot& getSnapshot( );
 
             void demoSpawner( );
 
             Object& addNewObject( sf::Vector2f startPos, float r, bool pinned = false);
             Stick& addNewStick( int id1, int id2, float length );
-            void makeStickChain( );
+            void makeStickChain( sf::Vector2f position );
             void spawnStick( );
-            void createJoint( );
+            void createJoint( sf::Vector2f position );
             void clearEverything( );
 
             void togglePause( );
             void toggleGravity( );
             void toggleBuild( );
 
+            void setBroadPhase( BroadPhase broadPhase );
+            const BroadPhase getBroadPhase( ) const;
+            void setNeighbourSkin( float skin );
+            // ticks is how many ticks in a row an island has to be still for before it sleeps
+            void setSleeping( bool enabled, float speed, int ticks );
+            void setStickSolver( StickSolver solver );
+            // solves grid contacts one island per task instead of in column stripes
+            void setIslandContacts( bool enabled );
+            // how soft every stick is, 0 is rigid, the stiffness doesn't change with the substep count
+            void setStickCompliance( float compliance );
+            const float getStickCompliance( ) const;
+            const StickSolver getStickSolver( ) const;
+            void setSimdLevel( SimdKernels::Level level );
+            void setStrictMath( bool strict );
+            void setBatchedNarrowPhase( bool batched );
+            void setThreadCount( int count );
+            const int getThreadCount( ) const;
+
 
             void changeMouseRadius( float change );
 
@@ -170,7 +425,18 @@ namespace pe {
 
             const float getSubDeltaTime( ) const;
             const int getSubSteps( ) const;
+            // counts below 0 are treated as 0, which turns that phase off
+            void setSchedule( const SolverSchedule& schedule );
+            const SolverSchedule& getSchedule( ) const;
             const float getTime( ) const;
+
+            void setFixedTimestep( bool enabled );
+            void setTickRate( float ticksPerSecond );
+            void setMaxTicksPerFrame( int ticks );
+            // only used when the timestep isn't fixed
+            void setMaxFrameRate( float framesPerSecond );
+            const float getTickRate( ) const;
+            const float getAlpha( ) const;
             IDVector<Object>& getObjects( );
             IDVector<Stick>& getSticks( );
 
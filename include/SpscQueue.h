@@ -0,0 +1,47 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace pe {
+
+    // fixed size ring buffer for exactly one thread pushing and one thread popping, neither ever waits
+    template <typename T, std::size_t Capacity>
+    class SpscQueue
+    {
+        private:
+            // one slot is always left empty so a full queue can be told apart from an empty one
+            T m_items[Capacity];
+            // next slot to pop, only written by the consumer
+            std::atomic<std::size_t> m_head { 0 };
+            // next slot to push, only written by the producer
+            std::atomic<std::size_t> m_tail { 0 };
+
+        public:
+            // returns false and drops the item if the queue is full
+            bool push( const T& item )
+            {
+                std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                std::size_t next = (tail + 1) % Capacity;
+                if(next == m_head.load(std::memory_order_acquire))
+                    return false;
+                m_items[tail] = item;
+                m_tail.store(next, std::memory_order_release);
+                return true;
+            }
+
+            bool pop( T& item )
+            {
+                std::size_t head = m_head.load(std::memory_order_relaxed);
+                if(head == m_tail.load(std::memory_order_acquire))
+                    return false;
+                item = m_items[head];
+                m_head.store((head + 1) % Capacity, std::memory_order_release);
+                return true;
+            }
+    };
+
+};
+
+#endif //!SPSCQUEUE_H
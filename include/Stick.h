@@ -11,11 +11,25 @@ struct Stick
     int ID;
 
     float length;
+    // xpbd compliance, the inverse of stiffness, 0 is a rigid stick
+    float compliance = 0.f;
 
     Stick( int stickID, int id1, int id2, float length );
+};
 
-    // in simulation class, set object references based on the ID
-    void update( Object& obj1, Object& obj2 );
+// a stick with its objects already looked up, the simulation rebuilds these whenever objects or sticks
+// are added, deleted or pinned so the solver never has to go through the IDs
+struct CompiledStick
+{
+    int index1;
+    int index2;
+    float length;
+    // 0 for pinned objects
+    float invMass1;
+    float invMass2;
+    float compliance;
+    // accumulated over the iterations of one substep, has to be reset to 0 at the start of every substep
+    float lambda;
 };
 
 #endif //!STICK_H
@@ -0,0 +1,40 @@
+#ifndef STICKCOLOURING_H
+#define STICKCOLOURING_H
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Stick.h"
+
+namespace pe {
+
+    // splits the sticks into colours where no two sticks of the same colour share an object,
+    // so every stick in a colour can be solved at the same time without two threads moving the same ball
+    class StickColouring
+    {
+        private:
+            // sticks grouped by colour, colour c is m_sticks[m_colourStart[c]] .. m_sticks[m_colourStart[c+1]]
+            std::vector<CompiledStick> m_sticks;
+            std::vector<int> m_colourStart = { 0 };
+
+            std::vector<std::uint64_t> m_usedColours;
+            std::vector<int> m_stickColour;
+
+            // more colours than this means some object has over 64 sticks, those go in one last colour that is solved in order
+            static const int s_maxColours = 64;
+
+        public:
+            // greedy colouring, only needs redoing when sticks or objects are added or removed
+            void build( const std::vector<CompiledStick>& sticks, std::size_t objectCount );
+
+            const int getColourCount( ) const;
+            const bool isSequentialColour( int colour ) const;
+            std::vector<CompiledStick>& getSticks( );
+            const int getColourBegin( int colour ) const;
+            const int getColourEnd( int colour ) const;
+    };
+
+};
+
+#endif //!STICKCOLOURING_H
@@ -0,0 +1,58 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+#pragma once
+#include <vector>
+
+#include "ParticleStore.h"
+
+namespace pe {
+
+    // sweep and prune along the x axis
+    // the intervals stay sorted between substeps and frames, and are re-sorted with an insertion sort,
+    // so when the balls barely move (settled piles, hanging ropes) an update is close to O(n)
+    class SweepAndPrune
+    {
+        private:
+            struct Interval
+            {
+                float minX;
+                float maxX;
+                float minY;
+                float maxY;
+                int index;
+            };
+
+            std::vector<Interval> m_intervals;
+            unsigned int m_topologyVersion = 0;
+            bool m_built = false;
+
+        private:
+            void rebuild( const ParticleStore& particles );
+            void refreshBounds( const ParticleStore& particles );
+            void insertionSort( );
+
+        public:
+            // topologyVersion changes whenever objects are added or deleted, the list is then rebuilt from scratch
+            void update( const ParticleStore& particles, unsigned int topologyVersion );
+
+            // calls func(index1, index2) for every pair of objects whose bounding boxes overlap
+            template<typename F>
+            void forEachPair( F&& func ) const
+            {
+                std::size_t count = m_intervals.size();
+                for(std::size_t i = 0; i < count; ++i)
+                {
+                    const Interval& a = m_intervals[i];
+                    for(std::size_t j = i + 1; j < count && m_intervals[j].minX <= a.maxX; ++j)
+                    {
+                        const Interval& b = m_intervals[j];
+                        if(a.minY <= b.maxY && b.minY <= a.maxY)
+                            func(a.index, b.index);
+                    }
+                }
+            }
+    };
+
+};
+
+#endif //!SWEEPANDPRUNE_H
@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pe {
+
+    // persistent worker threads so the simulation doesn't create threads every substep
+    class ThreadPool
+    {
+        private:
+            std::vector<std::thread> m_workers;
+
+            std::mutex m_mutex;
+            std::condition_variable m_workCondition;
+            std::condition_variable m_doneCondition;
+
+            const std::function<void(int)>* m_task = nullptr;
+            int m_taskCount = 0;
+            std::atomic<int> m_nextTask{ 0 };
+            int m_busyWorkers = 0;
+            unsigned int m_generation = 0;
+            bool m_stopping = false;
+
+        private:
+            void workerLoop( unsigned int seenGeneration );
+            void runTasks( );
+            void stopWorkers( );
+
+        public:
+            ThreadPool( );
+            ~ThreadPool( );
+
+            // total number of threads that run tasks, including the thread calling run
+            void setThreadCount( int count );
+            const int getThreadCount( ) const;
+
+            // calls task(i) for every i in [0, taskCount) spread over the threads, returns once they are all done
+            void run( int taskCount, const std::function<void(int)>& task );
+    };
+
+};
+
+#endif //!THREADPOOL_H
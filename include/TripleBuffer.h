@@ -0,0 +1,56 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+#pragma once
+#include <atomic>
+
+namespace pe {
+
+    // hands the newest T from one writer thread to one reader thread, neither side ever waits on the other
+    // the writer fills its back buffer then swaps it with the middle one, the reader swaps the middle one with
+    // its front buffer whenever something new has been published, so each side always has a buffer to itself
+    template <typename T>
+    class TripleBuffer
+    {
+        private:
+            // set on the middle index when it holds something the reader hasn't seen yet
+            static const int s_freshBit = 1 << 2;
+
+            T m_buffers[3];
+            std::atomic<int> m_middle { 1 };
+            // only touched by the writer
+            int m_back = 0;
+            // only touched by the reader
+            int m_front = 2;
+
+        public:
+            // the writer's buffer, it still has whatever was in it last time so it has to be filled in completely
+            T& getWriteBuffer( )
+            {
+                return m_buffers[m_back];
+            }
+
+            void publish( )
+            {
+                int old = m_middle.exchange(m_back | s_freshBit, std::memory_order_acq_rel);
+                m_back = old & ~s_freshBit;
+            }
+
+            // swaps in the newest published buffer, returns false if nothing new was published
+            bool update( )
+            {
+                if(!(m_middle.load(std::memory_order_relaxed) & s_freshBit))
+                    return false;
+                int old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+                m_front = old & ~s_freshBit;
+                return true;
+            }
+
+            const T& getReadBuffer( ) const
+            {
+                return m_buffers[m_front];
+            }
+    };
+
+};
+
+#endif //!TRIPLEBUFFER_H
@@ -17,6 +17,7 @@ Application::Application()
     : WINDOW_WIDTH(sf::VideoMode::getDesktopMode().width / 1.2)
     , WINDOW_HEIGHT(sf::VideoMode::getDesktopMode().height / 1.05)
     , m_guiHandler(m_sim)
+    , m_controlHandler(m_sim)
     /*
     : WINDOW_WIDTH(sf::VideoMode::getDesktopMode().width / 1.2), 
     WINDOW_HEIGHT(sf::VideoMode::getDesktopMode().height / 1.05)
@@ -30,6 +31,13 @@ Application::Application()
 
     m_sim.setWindow(*m_window);
     m_sim.setSubSteps(12);
+    m_sim.setFixedTimestep(true);
+    // rendering interpolates between ticks, so the physics doesn't need to keep up with the monitor
+    m_sim.setTickRate(60.f);
+    m_sim.setThreadCount(std::thread::hardware_concurrency());
+    m_sim.setStickSolver(pe::StickSolver::COLOURED_PARALLEL);
+    m_sim.setRenderMode(pe::RenderMode::TEXTURED_QUADS);
+    m_sim.setStickVertexBuffer(true);
 
 
 
@@ -87,7 +95,8 @@ void Application::pollEvents()
                 m_window->close();
                 break;
             case sf::Event::MouseWheelMoved:
-                m_sim.changeMouseRadius(m_event.mouseWheel.delta);
+                m_sim.pushCommand({ pe::SimCommand::CHANGE_MOUSE_RADIUS, { 0.f, 0.f }, static_cast<float>(m_event.mouseWheel.delta) });
+                break;
             default:
                 break;
         }
@@ -118,15 +127,12 @@ void Application::toggleFullscreen( )
                 m_isFullScreen = !m_isFullScreen;
                 
 
-                m_sim.setConstraintDimensions(m_window->getSize().x - GUI_PANEL_SIZE, m_window->getSize().y);
+                sf::Vector2f bounds(m_window->getSize().x - GUI_PANEL_SIZE, m_window->getSize().y);
+                m_sim.pushCommand({ pe::SimCommand::SET_BOUNDS, bounds });
                 m_guiHandler.setContraints(m_window->getSize().x - GUI_PANEL_SIZE, m_window->getSize().y);
                 // updates the buttons positions with the new screen size
                 m_guiHandler.initButtons();
-                IDVector<Object>& objs = m_sim.getObjects();
-                for(auto& obj : objs)
-                {
-                    obj.setVelocity(sf::Vector2f(0,0), m_sim.getTime());
-                }
+                m_sim.pushCommand(pe::SimCommand::ZERO_VELOCITIES);
 
             }
 
@@ -164,7 +170,9 @@ void Application::update()
     sg::Button::update( );
     m_guiHandler.update();
 
-    m_sim.simulate();
+    // the simulation runs on its own thread, it only gets what it needs from the window through here
+    sf::Vector2f mousePosView = m_window->mapPixelToCoords(m_mousePosWindow);
+    m_controlHandler.update(mousePosView, m_window->hasFocus());
 
 }
 
@@ -195,6 +203,7 @@ void Application::run()
 {
     m_guiHandler.initButtons();
     m_sim.initSticks();
+    m_sim.startSim();
     while(this->isRunning())
     {
         Time::initDeltaTime();
@@ -206,8 +215,5 @@ void Application::run()
         this->render();
 
     }
+    m_sim.stopSim();
 }
-
-// TODO: change to set variables for the window width and height so that the thread which runns the simulation
-// no longer uses the window at all times, this means i can allow the user to change in and out of fullscreen 
-// and then trigger a function in the simulation class which re-assigns the window width and heihgt
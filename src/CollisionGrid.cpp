@@ -0,0 +1,102 @@
+#include "../include/CollisionGrid.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace pe;
+
+int CollisionGrid::toCell( float cell, int cellCount )
+{
+    // clamped while it's still a float, casting a nan or anything past the range of int is undefined
+    if(std::isnan(cell))
+        return 0;
+    return static_cast<int>(std::clamp(cell, 0.f, static_cast<float>(cellCount - 1)));
+}
+
+int CollisionGrid::getCellX( float x ) const
+{
+    return toCell(x * m_invCellSize, m_columns);
+}
+
+int CollisionGrid::getCellY( float y ) const
+{
+    return toCell(y * m_invCellSize, m_rows);
+}
+
+void CollisionGrid::setCellSize( float cellSize, float width, float height )
+{
+    width = std::max(width, 1.f);
+    height = std::max(height, 1.f);
+
+    // stops tiny balls in a big window from allocating a huge amount of empty cells
+    float minCellSize = std::sqrt((width * height) / static_cast<float>(s_maxCells));
+    m_cellSize = std::max(cellSize, minCellSize);
+    m_invCellSize = 1.f / m_cellSize;
+
+    m_columns = static_cast<int>(std::ceil(width * m_invCellSize));
+    m_rows = static_cast<int>(std::ceil(height * m_invCellSize));
+}
+
+template<typename IndexFn>
+void CollisionGrid::sortIntoCells( const ParticleStore& particles, std::size_t count, IndexFn indexAt )
+{
+    int cellCount = m_columns * m_rows;
+
+    m_cellStart.assign(cellCount + 1, 0);
+    m_objectCell.resize(count);
+    m_cellObjects.resize(count);
+
+    // counting sort of the particles into their cells
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        int index = indexAt(i);
+        int cell = getCellX(particles.x[index]) * m_rows + getCellY(particles.y[index]);
+        m_objectCell[i] = cell;
+        m_cellStart[cell + 1]++;
+    }
+
+    for(int c = 0; c < cellCount; ++c)
+        m_cellStart[c + 1] += m_cellStart[c];
+
+    m_cellCursor.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        m_cellObjects[m_cellCursor[m_objectCell[i]]++] = indexAt(i);
+    }
+}
+
+void CollisionGrid::build( const ParticleStore& particles, float width, float height, float margin )
+{
+    float maxRadius = 1.f;
+    for(float radius : particles.radius)
+        maxRadius = std::max(maxRadius, radius);
+
+    // cells are sized so that the biggest ball fits, this keeps every contact inside the 3x3 neighbourhood
+    setCellSize(maxRadius * 2.f + margin, width, height);
+    sortIntoCells(particles, particles.size(), [](std::size_t i){ return static_cast<int>(i); });
+}
+
+void CollisionGrid::build( const ParticleStore& particles, const std::vector<int>& indices, float cellSize, float width, float height )
+{
+    setCellSize(cellSize, width, height);
+    sortIntoCells(particles, indices.size(), [&indices](std::size_t i){ return indices[i]; });
+}
+
+const bool CollisionGrid::isEmpty( ) const
+{
+    return m_cellObjects.empty();
+}
+
+const float CollisionGrid::getCellSize( ) const
+{
+    return m_cellSize;
+}
+
+const int CollisionGrid::getColumns( ) const
+{
+    return m_columns;
+}
+
+const int CollisionGrid::getRows( ) const
+{
+    return m_rows;
+}
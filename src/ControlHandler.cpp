@@ -0,0 +1,88 @@
+#include "../include/ControlHandler.h"
+using namespace handler;
+
+ControlHandler::ControlHandler( pe::Simulation& sim )
+{
+    m_sim = &sim;
+}
+
+void ControlHandler::update( sf::Vector2f mousePos, bool hasFocus )
+{
+    pe::FrameInput input;
+    input.mousePos = mousePos;
+    input.hasFocus = hasFocus;
+    if(hasFocus)
+    {
+        input.leftHeld = InputHandler::isLeftMouseClicked();
+        input.rightHeld = InputHandler::isRightMouseClicked();
+        input.chainHeld = InputHandler::isSClicked();
+
+        // build mode could have been toggled by a command the simulation hasn't got to yet, that's at most a frame off
+        const pe::RenderSnapshot& snapshot = m_sim->getSnapshot();
+        if(snapshot.buildModeActive)
+            buildModeControls(mousePos, snapshot.stickFinished);
+
+        keyControls();
+    }
+    m_sim->setFrameInput(input);
+}
+
+void ControlHandler::buildModeControls( sf::Vector2f mousePos, bool stickFinished )
+{
+    if(InputHandler::isRightMouseClicked())
+    {
+        if(!m_isMouseHeld)
+        {
+            m_isMouseHeld = true;
+            m_sim->pushCommand({ pe::SimCommand::DELETE_BALL, mousePos });
+        }
+    }
+    else{
+        m_isMouseHeld = false;
+    }
+
+    if(InputHandler::isAClicked() && !stickFinished)
+    {
+        if(!m_buildKeyHeld)
+        {
+            m_buildKeyHeld = true;
+            m_sim->pushCommand(pe::SimCommand::FINISH_STICK);
+        }
+    }
+    else if(InputHandler::isWClicked() && stickFinished)
+    {
+        if(!m_buildKeyHeld)
+        {
+            m_buildKeyHeld = true;
+            m_sim->pushCommand({ pe::SimCommand::JOIN, mousePos });
+        }
+    }
+    else{
+        m_buildKeyHeld = false;
+    }
+}
+
+void ControlHandler::keyControls( )
+{
+    pe::SimCommand::Type type;
+    if(InputHandler::isCClicked())
+        type = pe::SimCommand::CLEAR;
+    else if(InputHandler::isSpaceClicked())
+        type = pe::SimCommand::TOGGLE_PAUSE;
+    else if(InputHandler::isGClicked())
+        type = pe::SimCommand::TOGGLE_GRAVITY;
+    else if(InputHandler::isQClicked())
+        type = pe::SimCommand::TOGGLE_PIN;
+    else if(InputHandler::isEClicked())
+        type = pe::SimCommand::TOGGLE_BUILD;
+    else{
+        m_isKeyHeld = false;
+        return;
+    }
+
+    if(!m_isKeyHeld)
+    {
+        m_isKeyHeld = true;
+        m_sim->pushCommand(type);
+    }
+}
@@ -119,26 +119,24 @@ void GuiHandler::initBuildButton()
 
 void GuiHandler::update()
 {
-
-
     if(m_clearButton.onClick())
     {
-        m_sim->clearEverything();
+        m_sim->pushCommand(pe::SimCommand::CLEAR);
     }
 
     if(m_gravityButton.onClick())
     {
-        m_sim->toggleGravity();
+        m_sim->pushCommand(pe::SimCommand::TOGGLE_GRAVITY);
     }
 
     if(m_pauseButton.onClick())
     {
-        m_sim->togglePause();
+        m_sim->pushCommand(pe::SimCommand::TOGGLE_PAUSE);
     }
 
     if(m_buildButton.onClick())
     {
-        m_sim->toggleBuild();
+        m_sim->pushCommand(pe::SimCommand::TOGGLE_BUILD);
     }
 
 }
@@ -0,0 +1,67 @@
+#include "../include/HierarchicalGrid.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace pe;
+
+void HierarchicalGrid::build( const ParticleStore& particles, float width, float height )
+{
+    float minRadius = 0.f;
+    float maxRadius = 0.f;
+    for(float radius : particles.radius)
+    {
+        if(minRadius == 0.f || radius < minRadius)
+            minRadius = radius;
+        maxRadius = std::max(maxRadius, radius);
+    }
+
+    // the smallest level fits the smallest ball, every level above it doubles the cell size
+    m_baseCellSize = std::max(minRadius, 0.5f) * 2.f;
+    int levelCount = 1;
+    while(levelCount < s_maxLevels && m_baseCellSize * static_cast<float>(1 << (levelCount - 1)) < maxRadius * 2.f)
+        ++levelCount;
+
+    m_levels.resize(levelCount);
+    m_levelObjects.resize(levelCount);
+    m_levelX.resize(levelCount);
+    m_levelY.resize(levelCount);
+    for(int level = 0; level < levelCount; ++level)
+    {
+        m_levelObjects[level].clear();
+        m_levelX[level].clear();
+        m_levelY[level].clear();
+    }
+
+    for(std::size_t i = 0; i < particles.size(); ++i)
+    {
+        int level = 0;
+        while(level < levelCount - 1 && m_baseCellSize * static_cast<float>(1 << level) < particles.radius[i] * 2.f)
+            ++level;
+
+        m_levelObjects[level].push_back(static_cast<int>(i));
+        m_levelX[level].push_back(particles.x[i]);
+        m_levelY[level].push_back(particles.y[i]);
+    }
+
+    for(int level = 0; level < levelCount; ++level)
+    {
+        // empty levels are skipped by forEachPair so they don't need their cells rebuilt
+        if(m_levelObjects[level].empty())
+            continue;
+
+        float cellSize = m_baseCellSize * static_cast<float>(1 << level);
+        if(level == levelCount - 1)
+            cellSize = std::max(cellSize, maxRadius * 2.f);
+        m_levels[level].build(particles, m_levelObjects[level], cellSize, width, height);
+    }
+}
+
+const int HierarchicalGrid::getLevelCount( ) const
+{
+    return static_cast<int>(m_levels.size());
+}
+
+const std::size_t HierarchicalGrid::getLevelSize( int level ) const
+{
+    return m_levelObjects[level].size();
+}
@@ -0,0 +1,121 @@
+#include "../include/IslandManager.h"
+#include <algorithm>
+
+using namespace pe;
+
+void IslandManager::reset( std::size_t objectCount )
+{
+    m_parent.resize(objectCount);
+    for(std::size_t i = 0; i < objectCount; ++i)
+        m_parent[i] = i;
+    m_size.assign(objectCount, 1);
+    m_grouped = false;
+}
+
+void IslandManager::addObject( )
+{
+    m_parent.push_back(m_parent.size());
+    m_size.push_back(1);
+    m_grouped = false;
+}
+
+int IslandManager::find( int a )
+{
+    // path halving, every other node on the way up is pointed at its grandparent
+    while(m_parent[a] != a)
+    {
+        m_parent[a] = m_parent[m_parent[a]];
+        a = m_parent[a];
+    }
+    return a;
+}
+
+void IslandManager::join( int a, int b )
+{
+    int rootA = find(a);
+    int rootB = find(b);
+    if(rootA == rootB)
+        return;
+
+    // the smaller tree goes under the bigger one so the trees stay shallow
+    if(m_size[rootA] < m_size[rootB])
+        std::swap(rootA, rootB);
+    m_parent[rootB] = rootA;
+    m_size[rootA] += m_size[rootB];
+    m_grouped = false;
+}
+
+void IslandManager::group( )
+{
+    std::size_t objectCount = m_parent.size();
+
+    // islands are numbered in the order their first object shows up
+    std::vector<int> rootIsland(objectCount, -1);
+    m_islandOf.resize(objectCount);
+    int islandCount = 0;
+    for(std::size_t i = 0; i < objectCount; ++i)
+    {
+        int root = find(i);
+        if(rootIsland[root] == -1)
+            rootIsland[root] = islandCount++;
+        m_islandOf[i] = rootIsland[root];
+    }
+
+    // counting sort of the objects by island
+    m_start.assign(islandCount + 1, 0);
+    for(int island : m_islandOf)
+        m_start[island + 1]++;
+    m_largestIsland = 0;
+    for(int k = 0; k < islandCount; ++k)
+    {
+        m_largestIsland = std::max(m_largestIsland, m_start[k + 1]);
+        m_start[k + 1] += m_start[k];
+    }
+
+    m_objects.resize(objectCount);
+    std::vector<int> cursor(m_start.begin(), m_start.end() - 1);
+    for(std::size_t i = 0; i < objectCount; ++i)
+        m_objects[cursor[m_islandOf[i]]++] = i;
+
+    m_grouped = true;
+}
+
+const bool IslandManager::isGrouped( ) const
+{
+    return m_grouped;
+}
+
+const std::size_t IslandManager::getObjectCount( ) const
+{
+    return m_parent.size();
+}
+
+const int IslandManager::getIslandCount( ) const
+{
+    return static_cast<int>(m_start.size()) - 1;
+}
+
+const int IslandManager::getIslandBegin( int island ) const
+{
+    return m_start[island];
+}
+
+const int IslandManager::getIslandEnd( int island ) const
+{
+    return m_start[island + 1];
+}
+
+const std::vector<int>& IslandManager::getIslandObjects( ) const
+{
+    return m_objects;
+}
+
+const int IslandManager::getIsland( int object ) const
+{
+    return m_islandOf[object];
+}
+
+const int IslandManager::getLargestIslandSize( ) const
+{
+    return m_largestIsland;
+}
@@ -0,0 +1,81 @@
+#include "../include/NeighbourList.h"
+#include <algorithm>
+
+using namespace pe;
+
+void NeighbourList::update( const ParticleStore& particles, float width, float height, unsigned int topologyVersion )
+{
+    if(needsRebuild(particles, topologyVersion))
+    {
+        rebuild(particles, width, height);
+        m_topologyVersion = topologyVersion;
+        m_built = true;
+        m_rebuildCount++;
+    }
+}
+
+bool NeighbourList::needsRebuild( const ParticleStore& particles, unsigned int topologyVersion ) const
+{
+    if(!m_built || topologyVersion != m_topologyVersion || m_buildX.size() != particles.size())
+        return true;
+
+    // two balls moving towards each other by half the skin each can just about close the gap
+    float maxMoveSq = m_skin * m_skin * 0.25f;
+    for(std::size_t i = 0; i < particles.size(); ++i)
+    {
+        float movedX = particles.x[i] - m_buildX[i];
+        float movedY = particles.y[i] - m_buildY[i];
+        if(movedX * movedX + movedY * movedY > maxMoveSq || particles.radius[i] != m_buildRadii[i])
+            return true;
+    }
+    return false;
+}
+
+void NeighbourList::rebuild( const ParticleStore& particles, float width, float height )
+{
+    std::size_t objectCount = particles.size();
+
+    m_buildX = particles.x;
+    m_buildY = particles.y;
+    m_buildRadii = particles.radius;
+
+    m_pairs.clear();
+    m_grid.build(particles, width, height, m_skin);
+    m_grid.forEachPair([&](int i, int j){
+        float axisX = particles.x[i] - particles.x[j];
+        float axisY = particles.y[i] - particles.y[j];
+        float reach = particles.radius[i] + particles.radius[j] + m_skin;
+        if(axisX * axisX + axisY * axisY < reach * reach)
+            m_pairs.emplace_back(std::min(i, j), std::max(i, j));
+    });
+
+    // counting sort of the pairs by their first object
+    m_start.assign(objectCount + 1, 0);
+    for(auto& pair : m_pairs)
+        m_start[pair.first + 1]++;
+    for(std::size_t i = 0; i < objectCount; ++i)
+        m_start[i + 1] += m_start[i];
+
+    m_neighbours.resize(m_pairs.size());
+    std::vector<int> cursor(m_start.begin(), m_start.end() - 1);
+    for(auto& pair : m_pairs)
+        m_neighbours[cursor[pair.first]++] = pair.second;
+}
+
+void NeighbourList::setSkin( float skin )
+{
+    m_skin = std::max(skin, 0.f);
+    m_built = false;
+}
+
+const float NeighbourList::getSkin( ) const
+{
+    return m_skin;
+}
+
+int NeighbourList::takeRebuildCount( )
+{
+    int count = m_rebuildCount;
+    m_rebuildCount = 0;
+    return count;
+}
@@ -4,6 +4,7 @@
 Object::Object( int id, sf::Vector2f startPos, float r, bool pinned )
     : currentPos { startPos }
     , oldPos { startPos }
+    , previousPos { startPos }
     , radius { r }
     , ID { id }
     , isPinned { pinned } 
@@ -0,0 +1,55 @@
+#include "../include/ParticleStore.h"
+
+using namespace pe;
+
+void ParticleStore::gather( IDVector<Object>& objects )
+{
+    std::size_t count = objects.size();
+    x.resize(count);
+    y.resize(count);
+    oldX.resize(count);
+    oldY.resize(count);
+    prevX.resize(count);
+    prevY.resize(count);
+    accX.resize(count);
+    accY.resize(count);
+    radius.resize(count);
+    mass.resize(count);
+    flags.resize(count);
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        Object& obj = objects[i];
+        x[i] = obj.currentPos.x;
+        y[i] = obj.currentPos.y;
+        oldX[i] = obj.oldPos.x;
+        oldY[i] = obj.oldPos.y;
+        prevX[i] = obj.previousPos.x;
+        prevY[i] = obj.previousPos.y;
+        accX[i] = obj.acceleration.x;
+        accY[i] = obj.acceleration.y;
+        radius[i] = obj.radius;
+        mass[i] = obj.mass;
+        // grabbing something wakes it straight away
+        flags[i] = (obj.isPinned ? PINNED : 0) | (obj.isGrabbed ? GRABBED : 0) | (obj.isSleeping && !obj.isGrabbed ? SLEEPING : 0);
+    }
+}
+
+void ParticleStore::beginTick( )
+{
+    prevX = x;
+    prevY = y;
+}
+
+void ParticleStore::scatter( IDVector<Object>& objects ) const
+{
+    for(std::size_t i = 0; i < size(); ++i)
+    {
+        Object& obj = objects[i];
+        obj.currentPos = { x[i], y[i] };
+        obj.oldPos = { oldX[i], oldY[i] };
+        obj.previousPos = { prevX[i], prevY[i] };
+        obj.acceleration = { accX[i], accY[i] };
+        obj.isSleeping = flags[i] & SLEEPING;
+    }
+}
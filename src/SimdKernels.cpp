@@ -0,0 +1,412 @@
+#include "../include/SimdKernels.h"
+
+#if defined(__x86_64__)
+#define PE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// a contracted multiply-add would stop the scalar path matching the sse/avx path bit for bit,
+// gcc ignores the standard pragma so it gets its own
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+using namespace pe;
+
+namespace {
+
+    void integrateScalar( ParticleStore& p, std::size_t begin, std::size_t end, float dt2 )
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            if(p.flags[i] & ParticleStore::FIXED)
+                continue;
+
+            float velX = p.x[i] - p.oldX[i];
+            float velY = p.y[i] - p.oldY[i];
+            p.oldX[i] = p.x[i];
+            p.oldY[i] = p.y[i];
+            p.x[i] = p.x[i] + velX + p.accX[i] * dt2;
+            p.y[i] = p.y[i] + velY + p.accY[i] * dt2;
+            p.accX[i] = 0.f;
+            p.accY[i] = 0.f;
+        }
+    }
+
+    void applyCollisionOffset( ParticleStore& p, int i, int j, float offsetX, float offsetY )
+    {
+        // pairs that are both asleep never get here, so this is an awake ball running into a sleeping one
+        if(!(p.flags[i] & ParticleStore::PINNED) && p.wakeByPush(i, offsetX, offsetY))
+        {
+            p.x[i] += offsetX;
+            p.y[i] += offsetY;
+        }
+        if(!(p.flags[j] & ParticleStore::PINNED) && p.wakeByPush(j, offsetX, offsetY))
+        {
+            p.x[j] -= offsetX;
+            p.y[j] -= offsetY;
+        }
+    }
+
+    void solveCollisionBlockScalar( ParticleStore& p, const PairBlock& block )
+    {
+        float offsetX[PairBlock::SIZE];
+        float offsetY[PairBlock::SIZE];
+        bool overlapping[PairBlock::SIZE];
+
+        for(int k = 0; k < block.count; ++k)
+        {
+            int i = block.first[k];
+            int j = block.second[k];
+            float axisX = p.x[i] - p.x[j];
+            float axisY = p.y[i] - p.y[j];
+            float distSq = axisX * axisX + axisY * axisY;
+            float minDist = p.radius[i] + p.radius[j];
+
+            // balls sitting exactly on top of each other have no axis to push along
+            overlapping[k] = distSq < minDist * minDist && distSq > 0.f;
+            if(!overlapping[k])
+                continue;
+
+            float invDist = 1.f / std::sqrt(distSq);
+            float percentage = (minDist - distSq * invDist) * invDist * 0.5f;
+            offsetX[k] = axisX * percentage;
+            offsetY[k] = axisY * percentage;
+        }
+
+        for(int k = 0; k < block.count; ++k)
+        {
+            if(overlapping[k])
+                applyCollisionOffset(p, block.first[k], block.second[k], offsetX[k], offsetY[k]);
+        }
+    }
+
+    void stickCorrectionsScalar( const ParticleStore& p, CompiledStick* sticks, std::size_t begin, std::size_t end,
+                                 float invDt2, float* offsetX, float* offsetY )
+    {
+        for(std::size_t s = begin; s < end; ++s)
+        {
+            CompiledStick& stick = sticks[s];
+            float axisX = p.x[stick.index2] - p.x[stick.index1];
+            float axisY = p.y[stick.index2] - p.y[stick.index1];
+            float distance = std::sqrt(axisX * axisX + axisY * axisY);
+            float alpha = stick.compliance * invDt2;
+            float denominator = stick.invMass1 + stick.invMass2 + alpha;
+
+            if(denominator <= 0.f || distance <= 0.f)
+            {
+                offsetX[s] = 0.f;
+                offsetY[s] = 0.f;
+                continue;
+            }
+
+            float deltaLambda = (stick.length - distance - alpha * stick.lambda) / denominator;
+            stick.lambda = stick.lambda + deltaLambda;
+            offsetX[s] = axisX / distance * deltaLambda;
+            offsetY[s] = axisY / distance * deltaLambda;
+        }
+    }
+
+#ifdef PE_SIMD_X86
+
+    // all bits set in the lanes that aren't pinned or asleep
+    __m128 freeMask4( const std::uint8_t* flags )
+    {
+        int packed;
+        std::memcpy(&packed, flags, sizeof(packed));
+        __m128i zero = _mm_setzero_si128();
+        __m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        __m128i pinned = _mm_and_si128(lanes, _mm_set1_epi32(ParticleStore::FIXED));
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(pinned, zero));
+    }
+
+    __m128 select4( __m128 mask, __m128 ifSet, __m128 ifClear )
+    {
+        return _mm_or_ps(_mm_and_ps(mask, ifSet), _mm_andnot_ps(mask, ifClear));
+    }
+
+    std::size_t integrateSse2( ParticleStore& p, std::size_t count, float dt2 )
+    {
+        __m128 dt2v = _mm_set1_ps(dt2);
+        __m128 zero = _mm_setzero_ps();
+        std::size_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 mask = freeMask4(&p.flags[i]);
+            __m128 x = _mm_loadu_ps(&p.x[i]);
+            __m128 y = _mm_loadu_ps(&p.y[i]);
+            __m128 oldX = _mm_loadu_ps(&p.oldX[i]);
+            __m128 oldY = _mm_loadu_ps(&p.oldY[i]);
+            __m128 accX = _mm_loadu_ps(&p.accX[i]);
+            __m128 accY = _mm_loadu_ps(&p.accY[i]);
+
+            __m128 newX = _mm_add_ps(_mm_add_ps(x, _mm_sub_ps(x, oldX)), _mm_mul_ps(accX, dt2v));
+            __m128 newY = _mm_add_ps(_mm_add_ps(y, _mm_sub_ps(y, oldY)), _mm_mul_ps(accY, dt2v));
+
+            _mm_storeu_ps(&p.x[i], select4(mask, newX, x));
+            _mm_storeu_ps(&p.y[i], select4(mask, newY, y));
+            _mm_storeu_ps(&p.oldX[i], select4(mask, x, oldX));
+            _mm_storeu_ps(&p.oldY[i], select4(mask, y, oldY));
+            _mm_storeu_ps(&p.accX[i], select4(mask, zero, accX));
+            _mm_storeu_ps(&p.accY[i], select4(mask, zero, accY));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    __m256 freeMask8( const std::uint8_t* flags )
+    {
+        __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags)));
+        __m256i pinned = _mm256_and_si256(lanes, _mm256_set1_epi32(ParticleStore::FIXED));
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(pinned, _mm256_setzero_si256()));
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t integrateAvx2( ParticleStore& p, std::size_t count, float dt2 )
+    {
+        __m256 dt2v = _mm256_set1_ps(dt2);
+        __m256 zero = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 mask = freeMask8(&p.flags[i]);
+            __m256 x = _mm256_loadu_ps(&p.x[i]);
+            __m256 y = _mm256_loadu_ps(&p.y[i]);
+            __m256 oldX = _mm256_loadu_ps(&p.oldX[i]);
+            __m256 oldY = _mm256_loadu_ps(&p.oldY[i]);
+            __m256 accX = _mm256_loadu_ps(&p.accX[i]);
+            __m256 accY = _mm256_loadu_ps(&p.accY[i]);
+
+            __m256 newX = _mm256_add_ps(_mm256_add_ps(x, _mm256_sub_ps(x, oldX)), _mm256_mul_ps(accX, dt2v));
+            __m256 newY = _mm256_add_ps(_mm256_add_ps(y, _mm256_sub_ps(y, oldY)), _mm256_mul_ps(accY, dt2v));
+
+            _mm256_storeu_ps(&p.x[i], _mm256_blendv_ps(x, newX, mask));
+            _mm256_storeu_ps(&p.y[i], _mm256_blendv_ps(y, newY, mask));
+            _mm256_storeu_ps(&p.oldX[i], _mm256_blendv_ps(oldX, x, mask));
+            _mm256_storeu_ps(&p.oldY[i], _mm256_blendv_ps(oldY, y, mask));
+            _mm256_storeu_ps(&p.accX[i], _mm256_blendv_ps(accX, zero, mask));
+            _mm256_storeu_ps(&p.accY[i], _mm256_blendv_ps(accY, zero, mask));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2,fma")))
+    std::size_t integrateAvx2Fma( ParticleStore& p, std::size_t count, float dt2 )
+    {
+        __m256 dt2v = _mm256_set1_ps(dt2);
+        __m256 zero = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 mask = freeMask8(&p.flags[i]);
+            __m256 x = _mm256_loadu_ps(&p.x[i]);
+            __m256 y = _mm256_loadu_ps(&p.y[i]);
+            __m256 oldX = _mm256_loadu_ps(&p.oldX[i]);
+            __m256 oldY = _mm256_loadu_ps(&p.oldY[i]);
+            __m256 accX = _mm256_loadu_ps(&p.accX[i]);
+            __m256 accY = _mm256_loadu_ps(&p.accY[i]);
+
+            __m256 newX = _mm256_fmadd_ps(accX, dt2v, _mm256_add_ps(x, _mm256_sub_ps(x, oldX)));
+            __m256 newY = _mm256_fmadd_ps(accY, dt2v, _mm256_add_ps(y, _mm256_sub_ps(y, oldY)));
+
+            _mm256_storeu_ps(&p.x[i], _mm256_blendv_ps(x, newX, mask));
+            _mm256_storeu_ps(&p.y[i], _mm256_blendv_ps(y, newY, mask));
+            _mm256_storeu_ps(&p.oldX[i], _mm256_blendv_ps(oldX, x, mask));
+            _mm256_storeu_ps(&p.oldY[i], _mm256_blendv_ps(oldY, y, mask));
+            _mm256_storeu_ps(&p.accX[i], _mm256_blendv_ps(accX, zero, mask));
+            _mm256_storeu_ps(&p.accY[i], _mm256_blendv_ps(accY, zero, mask));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    void solveCollisionBlockAvx2( ParticleStore& p, const PairBlock& block, bool strict )
+    {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.first));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.second));
+
+        __m256 axisX = _mm256_sub_ps(_mm256_i32gather_ps(p.x.data(), first, 4), _mm256_i32gather_ps(p.x.data(), second, 4));
+        __m256 axisY = _mm256_sub_ps(_mm256_i32gather_ps(p.y.data(), first, 4), _mm256_i32gather_ps(p.y.data(), second, 4));
+        __m256 minDist = _mm256_add_ps(_mm256_i32gather_ps(p.radius.data(), first, 4), _mm256_i32gather_ps(p.radius.data(), second, 4));
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(axisX, axisX), _mm256_mul_ps(axisY, axisY));
+
+        __m256 overlapping = _mm256_and_ps(
+            _mm256_cmp_ps(distSq, _mm256_mul_ps(minDist, minDist), _CMP_LT_OQ),
+            _mm256_cmp_ps(distSq, _mm256_setzero_ps(), _CMP_GT_OQ));
+        int lanes = _mm256_movemask_ps(overlapping) & ((1 << block.count) - 1);
+        if(lanes == 0)
+            return;
+
+        // approximate 1/sqrt refined with one newton step, rsqrt isn't the same on every cpu so strict divides instead
+        __m256 half = _mm256_set1_ps(0.5f);
+        __m256 invDist;
+        if(strict)
+        {
+            invDist = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(distSq));
+        }
+        else
+        {
+            invDist = _mm256_rsqrt_ps(distSq);
+            __m256 halfDistSq = _mm256_mul_ps(half, distSq);
+            invDist = _mm256_mul_ps(invDist, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(halfDistSq, _mm256_mul_ps(invDist, invDist))));
+        }
+
+        __m256 distance = _mm256_mul_ps(distSq, invDist);
+        __m256 percentage = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(minDist, distance), invDist), half);
+
+        alignas(32) float offsetX[PairBlock::SIZE];
+        alignas(32) float offsetY[PairBlock::SIZE];
+        _mm256_store_ps(offsetX, _mm256_mul_ps(axisX, percentage));
+        _mm256_store_ps(offsetY, _mm256_mul_ps(axisY, percentage));
+
+        for(int k = 0; k < PairBlock::SIZE; ++k)
+        {
+            if(lanes & (1 << k))
+                applyCollisionOffset(p, block.first[k], block.second[k], offsetX[k], offsetY[k]);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t stickCorrectionsAvx2( const ParticleStore& p, CompiledStick* sticks, std::size_t count,
+                                      float invDt2, float* offsetX, float* offsetY )
+    {
+        // the sticks are read straight out of the compiled array, so each lane strides over a whole stick
+        static_assert(sizeof(CompiledStick) % sizeof(int) == 0, "compiled sticks must be made of 4 byte fields");
+        const int stride = sizeof(CompiledStick) / sizeof(int);
+        __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+        __m256 invDt2v = _mm256_set1_ps(invDt2);
+        __m256 zero = _mm256_setzero_ps();
+        alignas(32) float lambdas[8];
+
+        std::size_t s = 0;
+        for(; s + 8 <= count; s += 8)
+        {
+            const char* base = reinterpret_cast<const char*>(sticks + s);
+            __m256i first = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + offsetof(CompiledStick, index1)), lanes, 4);
+            __m256i second = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + offsetof(CompiledStick, index2)), lanes, 4);
+            __m256 length = _mm256_i32gather_ps(reinterpret_cast<const float*>(base + offsetof(CompiledStick, length)), lanes, 4);
+            __m256 invMass1 = _mm256_i32gather_ps(reinterpret_cast<const float*>(base + offsetof(CompiledStick, invMass1)), lanes, 4);
+            __m256 invMass2 = _mm256_i32gather_ps(reinterpret_cast<const float*>(base + offsetof(CompiledStick, invMass2)), lanes, 4);
+            __m256 compliance = _mm256_i32gather_ps(reinterpret_cast<const float*>(base + offsetof(CompiledStick, compliance)), lanes, 4);
+            __m256 lambda = _mm256_i32gather_ps(reinterpret_cast<const float*>(base + offsetof(CompiledStick, lambda)), lanes, 4);
+
+            __m256 axisX = _mm256_sub_ps(_mm256_i32gather_ps(p.x.data(), second, 4), _mm256_i32gather_ps(p.x.data(), first, 4));
+            __m256 axisY = _mm256_sub_ps(_mm256_i32gather_ps(p.y.data(), second, 4), _mm256_i32gather_ps(p.y.data(), first, 4));
+            __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(axisX, axisX), _mm256_mul_ps(axisY, axisY)));
+            __m256 alpha = _mm256_mul_ps(compliance, invDt2v);
+            __m256 denominator = _mm256_add_ps(_mm256_add_ps(invMass1, invMass2), alpha);
+            __m256 solvable = _mm256_and_ps(
+                _mm256_cmp_ps(denominator, zero, _CMP_GT_OQ),
+                _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+
+            __m256 deltaLambda = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(length, distance), _mm256_mul_ps(alpha, lambda)), denominator);
+            deltaLambda = _mm256_blendv_ps(zero, deltaLambda, solvable);
+            __m256 offX = _mm256_blendv_ps(zero, _mm256_mul_ps(_mm256_div_ps(axisX, distance), deltaLambda), solvable);
+            __m256 offY = _mm256_blendv_ps(zero, _mm256_mul_ps(_mm256_div_ps(axisY, distance), deltaLambda), solvable);
+
+            _mm256_storeu_ps(offsetX + s, offX);
+            _mm256_storeu_ps(offsetY + s, offY);
+
+            // there's no scatter in avx2, so the lambdas go back one at a time
+            _mm256_store_ps(lambdas, _mm256_add_ps(lambda, deltaLambda));
+            for(int k = 0; k < 8; ++k)
+                sticks[s + k].lambda = lambdas[k];
+        }
+        return s;
+    }
+
+#endif
+
+};
+
+SimdKernels::Level SimdKernels::getSupportedLevel( )
+{
+#ifdef PE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return SSE2;
+#endif
+    return SCALAR;
+}
+
+bool SimdKernels::supportsFma( )
+{
+#ifdef PE_SIMD_X86
+    static const bool fma = (__builtin_cpu_init(), __builtin_cpu_supports("fma"));
+    return fma;
+#else
+    return false;
+#endif
+}
+
+const char* SimdKernels::getLevelName( Level level )
+{
+    switch(level)
+    {
+        case SCALAR:
+            return "SCALAR";
+        case SSE2:
+            return "SSE2";
+        case AVX2:
+            return "AVX2";
+    }
+    return "NULL";
+}
+
+void SimdKernels::integrate( ParticleStore& particles, float subDeltaTime, Level level, bool useFma )
+{
+    float dt2 = subDeltaTime * subDeltaTime;
+    std::size_t count = particles.size();
+    std::size_t done = 0;
+
+#ifdef PE_SIMD_X86
+    if(level == AVX2 && useFma && supportsFma())
+        done = integrateAvx2Fma(particles, count, dt2);
+    else if(level == AVX2)
+        done = integrateAvx2(particles, count, dt2);
+    else if(level == SSE2)
+        done = integrateSse2(particles, count, dt2);
+#endif
+
+    // whatever didn't fill a whole vector
+    integrateScalar(particles, done, count, dt2);
+}
+
+void SimdKernels::solveCollisionBlock( ParticleStore& particles, PairBlock& block, Level level, bool strict )
+{
+#ifdef PE_SIMD_X86
+    if(level == AVX2)
+    {
+        // the unused lanes still get gathered from, so point them at a real particle
+        for(int k = block.count; k < PairBlock::SIZE; ++k)
+        {
+            block.first[k] = block.first[0];
+            block.second[k] = block.second[0];
+        }
+        solveCollisionBlockAvx2(particles, block, strict);
+        return;
+    }
+#endif
+    solveCollisionBlockScalar(particles, block);
+}
+
+void SimdKernels::stickCorrections( const ParticleStore& particles, CompiledStick* sticks, std::size_t count,
+                                    float invSubDeltaTimeSq, float* offsetX, float* offsetY, Level level )
+{
+    std::size_t done = 0;
+
+#ifdef PE_SIMD_X86
+    if(level == AVX2)
+        done = stickCorrectionsAvx2(particles, sticks, count, invSubDeltaTimeSq, offsetX, offsetY);
+#endif
+
+    stickCorrectionsScalar(particles, sticks, done, count, invSubDeltaTimeSq, offsetX, offsetY);
+}
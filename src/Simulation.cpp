@@ -4,6 +4,7 @@ using namespace pe;
 
 Simulation::~Simulation( )
 {
+    stopSim();
 }
 
 Simulation::Simulation( )
@@ -15,7 +16,18 @@ Simulation::Simulation( )
     m_mouseColShape.setOutlineThickness(1);
     m_mouseColShape.setOutlineColor(sf::Color::Red);
 
+    for(int i = 0; i < s_ballPointCount; ++i)
+    {
+        float angle = i * 2.f * Math::PI / s_ballPointCount - Math::PI / 2.f;
+        m_circlePoints.emplace_back(std::cos(angle), std::sin(angle));
+    }
+
     m_objects.reserve(MAXBALLS);
+    m_particles.wakeDistance = m_sleepSpeed;
+    m_simdLevel = SimdKernels::getSupportedLevel();
+    // draw and solve order don't matter, so deleting doesn't need to shift the rest of the scene down
+    m_objects.setUnorderedDelete(true);
+    m_sticks.setUnorderedDelete(true);
     initText();
     
 }
@@ -28,6 +40,18 @@ const void Simulation::setSubSteps( int substeps )
 {
     m_subStepNumber = substeps;
 }
+void Simulation::setSchedule( const SolverSchedule& schedule )
+{
+    m_schedule.stickIterations = std::max(schedule.stickIterations, 0);
+    m_schedule.collisionIterations = std::max(schedule.collisionIterations, 0);
+    m_schedule.boundaryIterations = std::max(schedule.boundaryIterations, 0);
+}
+
+const SolverSchedule& Simulation::getSchedule( ) const
+{
+    return m_schedule;
+}
+
 const float Simulation::getSubDeltaTime( ) const
 {
     return m_deltaTime / static_cast<float>(m_subStepNumber);
@@ -35,6 +59,8 @@ const float Simulation::getSubDeltaTime( ) const
 
 const void Simulation::setConstraintDimensions( int w, int h)
 {
+    if(w != m_constraintWidth || h != m_constraintHeight)
+        wakeAll();
     m_constraintWidth = w;
     m_constraintHeight = h;
 }
@@ -60,12 +86,29 @@ IDVector<Stick>& Simulation::getSticks( )
 
 Object& Simulation::addNewObject( sf::Vector2f startPos, float r, bool pinned )
 {
+    m_topologyVersion++;
+    if(m_islandsValid)
+        m_islands.addObject();
     return m_objects.emplaceBack(startPos, r, pinned); 
 }
 
 Stick& Simulation::addNewStick(int id1, int id2, float length)
 {
-    return m_sticks.emplaceBack(id1, id2, length);
+    m_topologyVersion++;
+    Stick& stick = m_sticks.emplaceBack(id1, id2, length);
+    stick.compliance = m_stickCompliance;
+    // a new stick can pull on a resting island
+    for(int id : { id1, id2 })
+    {
+        Object& obj = m_objects.getById(id);
+        obj.isSleeping = false;
+        obj.stillTicks = 0;
+    }
+    m_objectSticks[id1].push_back(stick.ID);
+    m_objectSticks[id2].push_back(stick.ID);
+    if(m_islandsValid)
+        m_islands.join(m_objects.findIndexById(id1), m_objects.findIndexById(id2));
+    return stick;
 }
 
 void Simulation::initText()
@@ -85,132 +128,189 @@ void Simulation::initText()
 
 void Simulation::setDeltaTime()
 {
-     m_deltaTime = m_deltaTimeClock.restart().asSeconds() * MULT;
+    float frameTime = m_deltaTimeClock.restart().asSeconds();
+    m_frameTime = frameTime;
+    if(m_fixedTimestep)
+    {
+        m_accumulator += frameTime;
+        m_deltaTime = MULT / m_tickRate;
+    }
+    else
+    {
+        m_deltaTime = frameTime * MULT;
+    }
+}
+
+void Simulation::setFixedTimestep( bool enabled )
+{
+    m_fixedTimestep = enabled;
+    m_accumulator = 0.f;
+    m_alpha = 1.f;
+}
+
+void Simulation::setTickRate( float ticksPerSecond )
+{
+    m_tickRate = std::max(ticksPerSecond, 1.f);
+}
+
+void Simulation::setMaxTicksPerFrame( int ticks )
+{
+    m_maxTicksPerFrame = std::max(ticks, 1);
+}
+
+void Simulation::setMaxFrameRate( float framesPerSecond )
+{
+    m_maxFrameRate = std::max(framesPerSecond, 1.f);
+}
+
+const float Simulation::getTickRate( ) const
+{
+    return m_tickRate;
+}
+
+const float Simulation::getAlpha( ) const
+{
+    return m_alpha;
 }
 // UPDATING
 void Simulation::updateText()
 {
+    updateIslands();
     std::stringstream ss;
     ss 
-        << "SIM TIME: " << m_simUpdateClock.restart().asMilliseconds() << "ms" << '\n'
+        << "SIM TIME: " << m_simFrameTime * 1000.f << "ms" << '\n'
         << "BALLS: " << m_objects.size() << '\n'
         << "GRAVITY: " << m_gravityActive << '\n'
-        << "BUILD: " << m_buildModeActive << '\n';
-        ;
-    m_debugText.setString(ss.str());
+        << "BUILD: " << m_buildModeActive << '\n'
+        << "BROADPHASE: " << getBroadPhaseName() << '\n'
+        << "TIMESTEP: " << (m_fixedTimestep ? "FIXED " : "VARIABLE ") << m_ticksThisFrame << " TICK(S)" << '\n'
+        << "THREADS: " << m_threadPool.getThreadCount() << '\n'
+        << "SIMD: " << SimdKernels::getLevelName(m_simdLevel) << (m_strictMath ? " (STRICT)" : "") << '\n'
+        << "ITERATIONS: " << m_schedule.stickIterations << " STICK / " << m_schedule.collisionIterations << " COLLISION / "
+            << m_schedule.boundaryIterations << " BOUNDARY" << '\n'
+        << "SLEEPING: " << m_sleepingCount << '\n'
+        << "ISLANDS: " << m_islands.getIslandCount() << " (LARGEST " << m_islands.getLargestIslandSize() << ")" << '\n'
+        << "STICKS: " << m_sticks.size() << '\n'
+        << "STICK SOLVER: " << getStickSolverName(m_stickSolver) << '\n';
+    if(m_stickSolver == StickSolver::COLOURED_PARALLEL)
+        ss << "STICK COLOURS: " << m_stickColouring.getColourCount() << '\n';
+    if(m_islandContacts && m_contactIslands.isGrouped())
+        ss << "CONTACT ISLANDS: " << m_contactIslands.getIslandCount() << " (LARGEST " << m_contactIslands.getLargestIslandSize() << ")" << '\n';
+    if(m_broadPhase == BroadPhase::NEIGHBOUR_LIST)
+        ss << "LIST REBUILDS: " << m_neighbourList.takeRebuildCount() << '\n';
+    m_debugString = ss.str();
 
 
 }
 
-void Simulation::nonBuildModeMouseControls()
+const char* Simulation::getBroadPhaseName( ) const
 {
-
-    if(handler::InputHandler::isLeftMouseClicked())
+    switch(m_broadPhase)
     {
-        if(mouseHoveringBall())
-            m_grabbingBall = true;
-
-    }
-    else {
-        if(m_grabbingBall)
-        {
-            for(auto &obj : m_objects)
-            {
-                if(obj.isGrabbed)
-                {
-                    obj.isGrabbed = false;
-                    obj.outlineThic = 0;
-                    // this prevents the velocity shooting the ball when paused and grabbing a ball
-                    if(!m_paused)
-                        obj.addVelocity(m_mouseVelocity, getSubDeltaTime());
-                    else
-                        obj.setVelocity(sf::Vector2f(0,0), getSubDeltaTime());
-
-                }
-
-            }
-
-        }
-        m_grabbingBall = false;
+        case BroadPhase::ALL_PAIRS:
+            return "ALL PAIRS";
+        case BroadPhase::UNIFORM_GRID:
+            return "GRID";
+        case BroadPhase::HIERARCHICAL_GRID:
+            return "HIERARCHICAL GRID";
+        case BroadPhase::SWEEP_AND_PRUNE:
+            return "SWEEP AND PRUNE";
+        case BroadPhase::NEIGHBOUR_LIST:
+            return "NEIGHBOUR LIST";
     }
-
-    if(handler::InputHandler::isRightMouseClicked())
-        m_mouseColActive = true;
-    else
-        m_mouseColActive = false;
-
+    return "NULL";
 }
 
-void Simulation::buildModeMouseControls()
+void Simulation::heldControls( )
 {
-    if(handler::InputHandler::isLeftMouseClicked())
-    {
-            if(m_spawnClock.getElapsedTime().asSeconds() > m_spawnNewBallDelay 
-                    && m_mousePosView.x < m_constraintWidth - 5 && m_mousePosView.y < m_constraintHeight - m_mouseColRad)
-            {
-                Object& obj = addNewObject(m_mousePosView, m_mouseColRad, m_newBallPin);
-                obj.color = handler::ColorHandler::getRainbowColors(getTime());
-                m_spawnClock.restart();
-            }
-
-    }
-
-    if(handler::InputHandler::isRightMouseClicked())
+    if(!m_buildModeActive)
     {
-        if(!m_isMouseHeld)
+        if(m_input.leftHeld)
         {
-            m_isMouseHeld = true;
-            int delId;
-            if(mouseHoveringBall(delId))
-            {
-                deleteBall(delId);
-            }
-
+            // tried every frame it's held, so sweeping the mouse onto a ball picks it up
+            if(mouseHoveringBall(m_mousePosView))
+                m_grabbingBall = true;
+        }
+        else{
+            releaseGrabbed();
         }
+        m_mouseColActive = m_input.rightHeld;
     }
     else{
-        m_isMouseHeld = false;
-    }
+        if(m_input.leftHeld)
+            spawnBall(m_mousePosView);
 
-    if(handler::InputHandler::isSClicked())
-    {
-        if(m_spawnClock.getElapsedTime().asSeconds() > m_spawnNewBluePrintDelay)
+        if(m_input.chainHeld && m_objects.size() < MAXBALLS
+                && m_spawnClock.getElapsedTime().asSeconds() > m_spawnNewBluePrintDelay)
         {
-            makeStickChain();
+            makeStickChain(m_mousePosView);
             m_spawnClock.restart();
         }
     }
+}
 
-    if(handler::InputHandler::isAClicked() && !m_stickMaker.finishedStick)
+void Simulation::releaseGrabbed( )
+{
+    if(m_grabbingBall)
     {
-        if(!m_buildKeyHeld)
+        for(auto &obj : m_objects)
         {
-            m_buildKeyHeld = true;
-            spawnStick();
+            if(obj.isGrabbed)
+            {
+                obj.isGrabbed = false;
+                obj.outlineThic = 0;
+                // this prevents the velocity shooting the ball when paused and grabbing a ball
+                if(!m_paused)
+                    obj.addVelocity(m_mouseVelocity, getSubDeltaTime());
+                else
+                    obj.setVelocity(sf::Vector2f(0,0), getSubDeltaTime());
+
+            }
+
         }
+
     }
-    else if(handler::InputHandler::isWClicked() && m_stickMaker.finishedStick)
+    m_grabbingBall = false;
+}
+
+void Simulation::spawnBall( sf::Vector2f position )
+{
+    if(m_objects.size() >= MAXBALLS)
+        return;
+
+    if(m_spawnClock.getElapsedTime().asSeconds() > m_spawnNewBallDelay 
+            && position.x < m_constraintWidth - 5 && position.y < m_constraintHeight - m_mouseColRad)
     {
-        if(!m_buildKeyHeld)
+        Object& obj = addNewObject(position, m_mouseColRad, m_newBallPin);
+        obj.color = handler::ColorHandler::getRainbowColors(getTime());
+        m_spawnClock.restart();
+    }
+}
+
+void Simulation::togglePin( )
+{
+    if(m_grabbingBall)
+    {
+        for(auto &obj : m_objects)
         {
-            m_buildKeyHeld = true;
-            createJoint();
+            if(obj.isGrabbed)
+                obj.togglePinned();
+
         }
+        // pinning changes the compiled sticks' inverse masses
+        m_topologyVersion++;
     }
-    else{
-        m_buildKeyHeld = false;
+    else if(m_buildModeActive){
+        m_newBallPin = !m_newBallPin;
     }
-
-
-
 }
 
-void Simulation::createJoint()
+void Simulation::createJoint( sf::Vector2f position )
 {
     if(!m_gotFirstBallToJoin)
     {
         //get first selection ID
-        if(mouseHoveringBall(m_obj1LinkID))
+        if(mouseHoveringBall(position, m_obj1LinkID))
         {
 
             Object& obj1 = m_objects.getById(m_obj1LinkID);
@@ -223,7 +323,7 @@ void Simulation::createJoint()
     }else{
         // get second selection ID
 
-        if(mouseHoveringBall(m_obj2LinkID))
+        if(mouseHoveringBall(position, m_obj2LinkID))
         {
             Object& obj1 = m_objects.getById(m_obj1LinkID);
             obj1.isSelected = true;
@@ -290,7 +390,7 @@ void Simulation::spawnStick( )
 }
 
 
-void Simulation::makeStickChain()
+void Simulation::makeStickChain( sf::Vector2f position )
 {
     m_stickMaker.finishedStick = false;
     sf::CircleShape newStickShape;
@@ -300,7 +400,7 @@ void Simulation::makeStickChain()
     newStickShape.setRadius(m_mouseColRad);
     newStickShape.setOrigin(newStickShape.getRadius(), newStickShape.getRadius());
     newStickShape.setFillColor(handler::ColorHandler::getRainbowColors(getTime()));
-    newStickShape.setPosition(m_mousePosView);
+    newStickShape.setPosition(position);
     Builder::BluePrintStick newStickBluePrint;
     newStickBluePrint.shape = newStickShape;
     newStickBluePrint.isPinned = m_newBallPin;
@@ -314,27 +414,43 @@ void Simulation::makeStickChain()
 
 void Simulation::deleteBall( int& delID )
 {
-    for(std::size_t i = 0; i < m_sticks.size(); ++i)
+    auto found = m_objectSticks.find(delID);
+    if(found != m_objectSticks.end())
     {
-        if(m_sticks[i].obj1ID == delID || m_sticks[i].obj2ID == delID)
-        {
-            m_sticks.deleteElementById(m_sticks[i].ID);
-            i = 0;
-        }
-        if(m_sticks[i].obj2ID == delID || m_sticks[i].obj1ID == delID)
+        std::vector<int> stickIDs = std::move(found->second);
+        m_objectSticks.erase(found);
+
+        // the other end of each stick forgets about it too
+        for(int stickID : stickIDs)
         {
-            m_sticks.deleteElementById(m_sticks[i].ID);
-            i = 0;
+            Stick& stick = m_sticks.getById(stickID);
+            int otherID = stick.obj1ID == delID ? stick.obj2ID : stick.obj1ID;
+            auto other = m_objectSticks.find(otherID);
+            if(other != m_objectSticks.end())
+            {
+                std::vector<int>& otherSticks = other->second;
+                otherSticks.erase(std::remove(otherSticks.begin(), otherSticks.end(), stickID), otherSticks.end());
+                if(otherSticks.empty())
+                    m_objectSticks.erase(other);
+            }
         }
+        m_sticks.deleteElementsByIds(stickIDs);
     }
 
     m_objects.deleteElementById(delID);
+    m_topologyVersion++;
+    m_islandsValid = false;
+    // anything could have been resting on it
+    wakeAll();
 }
 void Simulation::clearEverything( )
 {
     m_sticks.clear();
+    m_objectSticks.clear();
     m_stickMaker.bluePrintSticks.clear();
     m_objects.clear();
+    m_topologyVersion++;
+    m_islandsValid = false;
 
 }
 
@@ -349,6 +465,7 @@ void Simulation::togglePause( )
 void Simulation::toggleGravity()
 {
     m_gravityActive = !m_gravityActive;
+    wakeAll();
 }
 
 void Simulation::toggleBuild()
@@ -356,72 +473,138 @@ void Simulation::toggleBuild()
     m_buildModeActive = !m_buildModeActive;
 }
 
-void Simulation::getInput()
+void Simulation::setBroadPhase( BroadPhase broadPhase )
 {
+    m_broadPhase = broadPhase;
+}
 
-    if(!m_buildModeActive)
-        nonBuildModeMouseControls();
-    else if(m_objects.size() < MAXBALLS)
-        buildModeMouseControls();
+const BroadPhase Simulation::getBroadPhase( ) const
+{
+    return m_broadPhase;
+}
 
-    if(handler::InputHandler::isCClicked())
-    {
-        if(!m_isKeyHeld)
-        {
-            m_isKeyHeld = true;
-            clearEverything();
-        }
+void Simulation::setNeighbourSkin( float skin )
+{
+    m_neighbourList.setSkin(skin);
+}
 
-    }
-    else if(handler::InputHandler::isSpaceClicked())
-    {
-        if(!m_isKeyHeld)
-        {
-            m_isKeyHeld = true;
-            togglePause();
-        }
-    }
-    else if(handler::InputHandler::isGClicked())
-    {
-        if(!m_isKeyHeld)
-        {
-            m_isKeyHeld = true;
-            m_gravityActive = !m_gravityActive;
-        }
-    }
-    else if(handler::InputHandler::isQClicked())
-    {
-        if(!m_isKeyHeld)
-        {
-            m_isKeyHeld = true;
-            if(m_grabbingBall)
-            {
-                for(auto &obj : m_objects)
-                {
-                    if(obj.isGrabbed)
-                        obj.togglePinned();
+void Simulation::setSleeping( bool enabled, float speed, int ticks )
+{
+    m_sleepingEnabled = enabled;
+    m_sleepSpeed = std::max(speed, 0.f);
+    m_sleepTicks = std::max(ticks, 1);
+    m_particles.wakeDistance = m_sleepSpeed;
+    if(!enabled)
+        wakeAll();
+}
 
-                }
-            }
-            else if(m_buildModeActive){
-                m_newBallPin = !m_newBallPin;
-            }
+void Simulation::setIslandContacts( bool enabled )
+{
+    m_islandContacts = enabled;
+}
 
-        }
-    }
-    else if(handler::InputHandler::isEClicked())
+void Simulation::setStickSolver( StickSolver solver )
+{
+    m_stickSolver = solver;
+}
+
+const StickSolver Simulation::getStickSolver( ) const
+{
+    return m_stickSolver;
+}
+
+void Simulation::setSimdLevel( SimdKernels::Level level )
+{
+    // never go above what the cpu can actually run
+    m_simdLevel = std::min(level, SimdKernels::getSupportedLevel());
+}
+
+void Simulation::setStrictMath( bool strict )
+{
+    m_strictMath = strict;
+}
+
+void Simulation::setBatchedNarrowPhase( bool batched )
+{
+    m_batchedNarrowPhase = batched;
+}
+
+void Simulation::setThreadCount( int count )
+{
+    m_threadPool.setThreadCount(count);
+}
+
+const int Simulation::getThreadCount( ) const
+{
+    return m_threadPool.getThreadCount();
+}
+
+void Simulation::pushCommand( const SimCommand& command )
+{
+    // the simulation was busy for a while, but nothing can go in ahead of what's still waiting
+    flushCommands();
+    if(!m_commandBacklog.empty() || !m_commands.push(command))
+        m_commandBacklog.push_back(command);
+}
+
+void Simulation::flushCommands( )
+{
+    while(!m_commandBacklog.empty() && m_commands.push(m_commandBacklog.front()))
+        m_commandBacklog.pop_front();
+}
+
+void Simulation::executeCommands( )
+{
+    SimCommand command;
+    while(m_commands.pop(command))
+        executeCommand(command);
+}
+
+void Simulation::executeCommand( const SimCommand& command )
+{
+    switch(command.type)
     {
-        if(!m_isKeyHeld)
+        case SimCommand::DELETE_BALL:
         {
-            m_isKeyHeld = true;
-            m_buildModeActive = !m_buildModeActive;
-
+            int delId;
+            if(mouseHoveringBall(command.position, delId))
+                deleteBall(delId);
+            break;
         }
+        case SimCommand::FINISH_STICK:
+            if(m_objects.size() < MAXBALLS && !m_stickMaker.finishedStick)
+                spawnStick();
+            break;
+        case SimCommand::JOIN:
+            if(m_stickMaker.finishedStick)
+                createJoint(command.position);
+            break;
+        case SimCommand::CLEAR:
+            clearEverything();
+            break;
+        case SimCommand::TOGGLE_PAUSE:
+            togglePause();
+            break;
+        case SimCommand::TOGGLE_GRAVITY:
+            toggleGravity();
+            break;
+        case SimCommand::TOGGLE_BUILD:
+            toggleBuild();
+            break;
+        case SimCommand::TOGGLE_PIN:
+            togglePin();
+            break;
+        case SimCommand::CHANGE_MOUSE_RADIUS:
+            changeMouseRadius(command.amount);
+            break;
+        case SimCommand::SET_BOUNDS:
+            setConstraintDimensions(command.position.x, command.position.y);
+            break;
+        case SimCommand::ZERO_VELOCITIES:
+            for(auto& obj : m_objects)
+                obj.setVelocity({0,0}, getSubDeltaTime());
+            break;
     }
-    else{
-        m_isKeyHeld = false;
-    }
-
 }
 
 void Simulation::changeMouseRadius( float change )
@@ -456,7 +639,60 @@ void Simulation::changeMouseRadius( float change )
 
 void Simulation::updateMousePos()
 {
-    m_mousePosView = m_window->mapPixelToCoords(sf::Mouse::getPosition(*m_window));
+    m_frameInput.update();
+    m_input = m_frameInput.getReadBuffer();
+    m_mousePosView = m_input.mousePos;
+}
+
+void Simulation::calcMouseVelocity( )
+{
+    // how far the mouse moved since the last frame, turned into how far it would have moved in a 244 fps frame
+    sf::Vector2f moved = m_mousePosView - m_mouseOldPos;
+    m_mouseOldPos = m_mousePosView;
+    if(m_frameTime > 0.f)
+        m_mouseVelocity = moved * (s_mouseThrowFrameTime / m_frameTime);
+}
+
+void Simulation::setFrameInput( const FrameInput& input )
+{
+    m_frameInput.getWriteBuffer() = input;
+    m_frameInput.publish();
+    flushCommands();
+}
+
+void Simulation::startSim( )
+{
+    if(m_simRunning)
+        return;
+    m_simRunning = true;
+    m_updateThread = std::thread(&Simulation::simLoop, this);
+}
+
+void Simulation::stopSim( )
+{
+    m_simRunning = false;
+    if(m_updateThread.joinable())
+        m_updateThread.join();
+}
+
+void Simulation::simLoop( )
+{
+    while(m_simRunning)
+    {
+        simulate();
+
+        // nothing is due until the next tick, so there's no point spinning
+        float untilNextFrame;
+        if(m_fixedTimestep)
+            untilNextFrame = 1.f / m_tickRate - m_accumulator;
+        else
+            untilNextFrame = 1.f / m_maxFrameRate - m_simFrameTime;
+
+        if(untilNextFrame > 0.f)
+            std::this_thread::sleep_for(std::chrono::duration<float>(untilNextFrame));
+        else
+            std::this_thread::yield();
+    }
 }
 
 
@@ -467,32 +703,42 @@ void Simulation::simulate( )
     while(m_window->isOpen())
     {
     */
-            m_time+= m_deltaTime;
+            m_simUpdateClock.restart();
             updateText();
             setDeltaTime();
-            float subStepDT = getSubDeltaTime();
-            if(m_window->hasFocus())
-            {
-                getInput();
-            }
             updateMousePos();
-            
-            m_mouseVelocity = Math::getMouseVelocity(m_mousePosView);
+            executeCommands();
+            heldControls();
+
+            calcMouseVelocity();
+            updateGrabbedOutline();
 
-            for(int i{getSubSteps()}; i > 0; --i)
+            m_particles.gather(m_objects);
+
+            if(m_fixedTimestep)
             {
-                if(m_window->hasFocus() && !m_paused)
+                float tickTime = 1.f / m_tickRate;
+                m_ticksThisFrame = 0;
+                while(m_accumulator >= tickTime && m_ticksThisFrame < m_maxTicksPerFrame)
                 {
-                    if(m_gravityActive)
-                        applyGravityToObjects();
-                    updateObjects( getSubDeltaTime() );
-                    updateSticks();
-
+                    step();
+                    m_accumulator -= tickTime;
+                    m_ticksThisFrame++;
                 }
-                ballGrabbedMovement();
-                checkConstraints();
-                checkCollisions();
+                // couldn't keep up, only the part of a tick that's left is kept
+                if(m_accumulator >= tickTime)
+                    m_accumulator = std::fmod(m_accumulator, tickTime);
+                m_alpha = m_accumulator / tickTime;
             }
+            else
+            {
+                step();
+                m_ticksThisFrame = 1;
+                m_alpha = 1.f;
+            }
+            m_particles.scatter(m_objects);
+            publishSnapshot();
+            m_simFrameTime = m_simUpdateClock.getElapsedTime().asSeconds();
 
 
     /*
@@ -502,6 +748,54 @@ void Simulation::simulate( )
 
 }
 
+void Simulation::advance( int ticks )
+{
+    m_deltaTime = MULT / m_tickRate;
+    updateMousePos();
+    executeCommands();
+    heldControls();
+
+    m_particles.gather(m_objects);
+    for(int i = 0; i < ticks; ++i)
+        step();
+    m_ticksThisFrame = ticks;
+    m_alpha = 1.f;
+    m_particles.scatter(m_objects);
+    publishSnapshot();
+}
+
+void Simulation::step( )
+{
+    // one tick of m_deltaTime, run on the gathered particles
+    m_time += m_deltaTime;
+    m_particles.beginTick();
+    for(int i{getSubSteps()}; i > 0; --i)
+    {
+        if(m_input.hasFocus && !m_paused)
+        {
+            if(m_gravityActive)
+                applyGravityToObjects();
+            updateObjects( getSubDeltaTime() );
+            updateSticks( getSubDeltaTime() );
+
+        }
+        ballGrabbedMovement();
+
+        // boundaries and collisions take turns so each sees what the other just moved
+        int constraintIterations = std::max(m_schedule.boundaryIterations, m_schedule.collisionIterations);
+        for(int k = 0; k < constraintIterations; ++k)
+        {
+            if(k < m_schedule.boundaryIterations)
+                checkConstraints();
+            if(k < m_schedule.collisionIterations)
+                checkCollisions();
+        }
+    }
+    // a paused scene isn't moving, that doesn't mean it has settled
+    if(m_input.hasFocus && !m_paused)
+        updateSleeping();
+}
+
 void Simulation::initSticks()
 {
     /*
@@ -586,21 +880,278 @@ void Simulation::initSticks()
 
 }
 
-void Simulation::updateSticks()
+void Simulation::compileSticks()
 {
+    m_compiledSticks.clear();
+    m_compiledSticks.reserve(m_sticks.size());
     for(auto& stick : m_sticks)
     {
-        stick.update(m_objects.getById(stick.obj1ID), m_objects.getById(stick.obj2ID));
+        int index1 = m_objects.findIndexById(stick.obj1ID);
+        int index2 = m_objects.findIndexById(stick.obj2ID);
+        if(index1 == -1 || index2 == -1)
+            continue;
+
+        Object& obj1 = m_objects[index1];
+        Object& obj2 = m_objects[index2];
+        m_compiledSticks.push_back({
+            index1,
+            index2,
+            stick.length,
+            obj1.isPinned ? 0.f : 1.f / obj1.mass,
+            obj2.isPinned ? 0.f : 1.f / obj2.mass,
+            stick.compliance,
+            0.f
+        });
+    }
+
+    m_compiledSticksVersion = m_topologyVersion;
+    m_sticksCompiled = true;
+    m_sticksColoured = false;
+    m_sticksIslanded = false;
+}
+
+void Simulation::updateSticks( float subDeltaTime )
+{
+    if(subDeltaTime <= 0.f)
+        return;
+    if(!m_sticksCompiled || m_compiledSticksVersion != m_topologyVersion)
+        compileSticks();
+
+    m_stickInvSubDeltaTimeSq = 1.f / (subDeltaTime * subDeltaTime);
+    resetStickLambdas();
+    for(int i = 0; i < m_schedule.stickIterations; ++i)
+        solveSticks(m_stickSolver);
+}
+
+void Simulation::resetStickLambdas()
+{
+    for(auto& stick : m_compiledSticks)
+        stick.lambda = 0.f;
+    // the coloured and island solvers work on their own reordered copies
+    if(m_sticksColoured)
+    {
+        for(auto& stick : m_stickColouring.getSticks())
+            stick.lambda = 0.f;
+    }
+    if(m_sticksIslanded)
+    {
+        for(auto& stick : m_islandSticks)
+            stick.lambda = 0.f;
+    }
+}
+
+void Simulation::solveSticks( StickSolver solver )
+{
+    switch(solver)
+    {
+        case StickSolver::SEQUENTIAL:
+            for(auto& stick : m_compiledSticks)
+            {
+                solveStick(stick);
+            }
+            break;
+        case StickSolver::COLOURED_PARALLEL:
+            updateSticksColoured();
+            break;
+        case StickSolver::JACOBI:
+            updateSticksJacobi();
+            break;
+        case StickSolver::ISLAND_PARALLEL:
+            updateSticksIslands();
+            break;
+    }
+}
+
+void Simulation::updateSticksIslands()
+{
+    if(!m_sticksIslanded)
+    {
+        updateIslands();
+
+        // counting sort of the compiled sticks by the island they're in
+        int islandCount = m_islands.getIslandCount();
+        std::vector<int> islandStart(islandCount + 1, 0);
+        for(auto& stick : m_compiledSticks)
+            islandStart[m_islands.getIsland(stick.index1) + 1]++;
+        for(int k = 0; k < islandCount; ++k)
+            islandStart[k + 1] += islandStart[k];
+
+        m_islandSticks.resize(m_compiledSticks.size());
+        std::vector<int> cursor(islandStart.begin(), islandStart.end() - 1);
+        for(auto& stick : m_compiledSticks)
+            m_islandSticks[cursor[m_islands.getIsland(stick.index1)]++] = stick;
+
+        splitIntoTasks(islandStart, STICKS_PER_TASK, m_islandStickTasks);
+        m_sticksIslanded = true;
+    }
+
+    int taskCount = static_cast<int>(m_islandStickTasks.size()) - 1;
+    m_threadPool.run(taskCount, [this](int task){
+        for(int s = m_islandStickTasks[task]; s < m_islandStickTasks[task + 1]; ++s)
+            solveStick(m_islandSticks[s]);
+    });
+}
+
+void Simulation::updateSticksColoured()
+{
+    // the colouring only changes with the topology, so it is redone whenever the sticks are recompiled
+    if(!m_sticksColoured)
+    {
+        m_stickColouring.build(m_compiledSticks, m_particles.size());
+        m_sticksColoured = true;
+    }
+
+    std::vector<CompiledStick>& sticks = m_stickColouring.getSticks();
+    for(int colour = 0; colour < m_stickColouring.getColourCount(); ++colour)
+    {
+        int begin = m_stickColouring.getColourBegin(colour);
+        int end = m_stickColouring.getColourEnd(colour);
+
+        if(m_stickColouring.isSequentialColour(colour))
+        {
+            for(int s = begin; s < end; ++s)
+                solveStick(sticks[s]);
+            continue;
+        }
+
+        // no two sticks in a colour share a ball, so the colour can be split up freely
+        int taskCount = (end - begin + STICKS_PER_TASK - 1) / STICKS_PER_TASK;
+        m_threadPool.run(taskCount, [this, &sticks, begin, end](int task){
+            int from = begin + task * STICKS_PER_TASK;
+            int to = std::min(end, from + STICKS_PER_TASK);
+            for(int s = from; s < to; ++s)
+                solveStick(sticks[s]);
+        });
+    }
+}
+
+void Simulation::updateSticksJacobi()
+{
+    std::size_t stickCount = m_compiledSticks.size();
+    std::size_t objectCount = m_particles.size();
+    m_stickOffsetX.resize(stickCount);
+    m_stickOffsetY.resize(stickCount);
+    m_jacobiLambda.resize(stickCount);
+    for(std::size_t s = 0; s < stickCount; ++s)
+        m_jacobiLambda[s] = m_compiledSticks[s].lambda;
+
+    // nothing is moved until every stick has its offset, so the chunks can run in any order
+    int taskCount = (static_cast<int>(stickCount) + STICKS_PER_TASK - 1) / STICKS_PER_TASK;
+    m_threadPool.run(taskCount, [this, stickCount](int task){
+        std::size_t from = static_cast<std::size_t>(task) * STICKS_PER_TASK;
+        std::size_t to = std::min(stickCount, from + STICKS_PER_TASK);
+        SimdKernels::stickCorrections(m_particles, m_compiledSticks.data() + from, to - from, m_stickInvSubDeltaTimeSq,
+                                      m_stickOffsetX.data() + from, m_stickOffsetY.data() + from, m_simdLevel);
+    });
+
+    m_jacobiCount.assign(objectCount, 0);
+    for(std::size_t s = 0; s < stickCount; ++s)
+    {
+        const CompiledStick& stick = m_compiledSticks[s];
+        if(m_particles.areBothSleeping(stick.index1, stick.index2))
+            continue;
+        if(stick.invMass1 > 0.f)
+            m_jacobiCount[stick.index1]++;
+        if(stick.invMass2 > 0.f)
+            m_jacobiCount[stick.index2]++;
+    }
+
+    // adding up every stick's step would overshoot, so each stick only takes 1 / n of it, n being the most
+    // sticks either of its balls has. lambda takes the same share, otherwise a compliant stick's lambda runs
+    // ahead of what was really applied and it comes out softer the more sticks its balls have
+    m_jacobiDeltaX.assign(objectCount, 0.f);
+    m_jacobiDeltaY.assign(objectCount, 0.f);
+    for(std::size_t s = 0; s < stickCount; ++s)
+    {
+        CompiledStick& stick = m_compiledSticks[s];
+        int count1 = stick.invMass1 > 0.f ? m_jacobiCount[stick.index1] : 0;
+        int count2 = stick.invMass2 > 0.f ? m_jacobiCount[stick.index2] : 0;
+        int count = std::max(count1, count2);
+        if(count == 0 || m_particles.areBothSleeping(stick.index1, stick.index2))
+        {
+            stick.lambda = m_jacobiLambda[s];
+            continue;
+        }
+
+        float weight = 1.f / count;
+        stick.lambda = m_jacobiLambda[s] + (stick.lambda - m_jacobiLambda[s]) * weight;
+        m_jacobiDeltaX[stick.index1] -= m_stickOffsetX[s] * stick.invMass1 * weight;
+        m_jacobiDeltaY[stick.index1] -= m_stickOffsetY[s] * stick.invMass1 * weight;
+        m_jacobiDeltaX[stick.index2] += m_stickOffsetX[s] * stick.invMass2 * weight;
+        m_jacobiDeltaY[stick.index2] += m_stickOffsetY[s] * stick.invMass2 * weight;
+    }
+
+    for(std::size_t i = 0; i < objectCount; ++i)
+    {
+        m_particles.x[i] += m_jacobiDeltaX[i];
+        m_particles.y[i] += m_jacobiDeltaY[i];
     }
 }
 
+const char* Simulation::getStickSolverName( StickSolver solver )
+{
+    switch(solver)
+    {
+        case StickSolver::SEQUENTIAL:
+            return "SEQUENTIAL";
+        case StickSolver::COLOURED_PARALLEL:
+            return "COLOURED";
+        case StickSolver::JACOBI:
+            return "JACOBI";
+        case StickSolver::ISLAND_PARALLEL:
+            return "ISLANDS";
+    }
+    return "NULL";
+}
+
+void Simulation::solveStick( CompiledStick& stick )
+{
+    // xpbd, the compliance term keeps the stiffness the same whatever the substep and iteration counts are,
+    // the lighter end moves further and pinned ends don't move at all
+    int i = stick.index1;
+    int j = stick.index2;
+    if(m_particles.areBothSleeping(i, j))
+        return;
+    float alpha = stick.compliance * m_stickInvSubDeltaTimeSq;
+    float denominator = stick.invMass1 + stick.invMass2 + alpha;
+
+    float axisX = m_particles.x[j] - m_particles.x[i];
+    float axisY = m_particles.y[j] - m_particles.y[i];
+    float distance = sqrt(axisX * axisX + axisY * axisY);
+    if(denominator <= 0.f || distance <= 0.f)
+        return;
+
+    float deltaLambda = (stick.length - distance - alpha * stick.lambda) / denominator;
+    stick.lambda += deltaLambda;
+    float offsetX = axisX / distance * deltaLambda;
+    float offsetY = axisY / distance * deltaLambda;
+    m_particles.x[i] -= offsetX * stick.invMass1;
+    m_particles.y[i] -= offsetY * stick.invMass1;
+    m_particles.x[j] += offsetX * stick.invMass2;
+    m_particles.y[j] += offsetY * stick.invMass2;
+}
+
+void Simulation::setStickCompliance( float compliance )
+{
+    m_stickCompliance = std::max(compliance, 0.f);
+    for(auto& stick : m_sticks)
+        stick.compliance = m_stickCompliance;
+    // the compiled sticks carry their own copy
+    m_sticksCompiled = false;
+}
+
+const float Simulation::getStickCompliance( ) const
+{
+    return m_stickCompliance;
+}
 
 
-bool Simulation::mouseHoveringBall()
+
+bool Simulation::mouseHoveringBall( sf::Vector2f position )
 {
     for(auto &obj: m_objects)
     {
-        sf::Vector2f axis = m_mousePosView - obj.currentPos;
+        sf::Vector2f axis = position - obj.currentPos;
         float dist = sqrt(axis.x * axis.x + axis.y * axis.y);
         
         if(dist < obj.radius && !m_grabbingBall)
@@ -613,11 +1164,11 @@ bool Simulation::mouseHoveringBall()
 
     return false;
 }
-bool Simulation::mouseHoveringBall( int& ID )
+bool Simulation::mouseHoveringBall( sf::Vector2f position, int& ID )
 {
     for(auto &obj: m_objects)
     {
-        sf::Vector2f axis = m_mousePosView - obj.currentPos;
+        sf::Vector2f axis = position - obj.currentPos;
         float dist = sqrt(axis.x * axis.x + axis.y * axis.y);
         
         if(dist < obj.radius && !m_grabbingBall)
@@ -630,7 +1181,132 @@ bool Simulation::mouseHoveringBall( int& ID )
     return false;
 }
 
+void Simulation::updateIslands( )
+{
+    // deletes shuffle the indices about, so the whole thing is joined up again from the sticks
+    if(!m_islandsValid || m_islands.getObjectCount() != m_objects.size())
+    {
+        m_islands.reset(m_objects.size());
+        for(auto& stick : m_sticks)
+        {
+            int index1 = m_objects.findIndexById(stick.obj1ID);
+            int index2 = m_objects.findIndexById(stick.obj2ID);
+            if(index1 != -1 && index2 != -1)
+                m_islands.join(index1, index2);
+        }
+        m_islandsValid = true;
+    }
+    if(!m_islands.isGrouped())
+        m_islands.group();
+}
+
+void Simulation::splitIntoTasks( const std::vector<int>& islandStart, int itemsPerTask, std::vector<int>& tasks )
+{
+    // tasks only ever end on an island boundary, so no island is split between two threads
+    tasks.clear();
+    tasks.push_back(0);
+    for(std::size_t k = 1; k < islandStart.size(); ++k)
+    {
+        if(islandStart[k] - tasks.back() >= itemsPerTask)
+            tasks.push_back(islandStart[k]);
+    }
+    if(tasks.back() != islandStart.back())
+        tasks.push_back(islandStart.back());
+}
+
+void Simulation::updateSleeping( )
+{
+    if(!m_sleepingEnabled)
+        return;
+    updateIslands();
+    const std::vector<int>& islandObjects = m_islands.getIslandObjects();
+
+    // the velocity is how far the last substep moved it, a sleeping object keeps the count it fell asleep with
+    // and anything woken by a hard enough contact or the mouse this tick starts again
+    float limitSq = m_sleepSpeed * m_sleepSpeed;
+    for(std::size_t i = 0; i < m_particles.size(); ++i)
+    {
+        if(m_particles.isSleeping(i))
+            continue;
+        Object& obj = m_objects[i];
+        float velX = m_particles.x[i] - m_particles.oldX[i];
+        float velY = m_particles.y[i] - m_particles.oldY[i];
+        // a push can be too gentle to show in the velocity, but it still has to keep the ball awake for a while
+        if(m_particles.isGrabbed(i) || m_particles.wasWoken(i) || velX * velX + velY * velY > limitSq)
+            obj.stillTicks = 0;
+        else if(obj.stillTicks < m_sleepTicks)
+            obj.stillTicks++;
+        m_particles.flags[i] &= ~ParticleStore::WOKEN;
+    }
+
+    // an island only sleeps once all of it is still, and anything that woke part of it this tick wakes the rest
+    m_sleepingCount = 0;
+    for(int island = 0; island < m_islands.getIslandCount(); ++island)
+    {
+        int begin = m_islands.getIslandBegin(island);
+        int end = m_islands.getIslandEnd(island);
+
+        int sleeping = 0;
+        bool still = true;
+        for(int k = begin; k < end; ++k)
+        {
+            int i = islandObjects[k];
+            if(m_particles.isSleeping(i))
+                sleeping++;
+            else if(m_objects[i].stillTicks < m_sleepTicks)
+                still = false;
+        }
+
+        if(sleeping == end - begin)
+        {
+            m_sleepingCount += sleeping;
+            continue;
+        }
+
+        for(int k = begin; k < end; ++k)
+        {
+            int i = islandObjects[k];
+            if(still)
+            {
+                // whatever velocity was left would come back as a jump when it wakes
+                m_particles.flags[i] |= ParticleStore::SLEEPING;
+                m_particles.oldX[i] = m_particles.x[i];
+                m_particles.oldY[i] = m_particles.y[i];
+                m_particles.accX[i] = 0.f;
+                m_particles.accY[i] = 0.f;
+            }
+            else
+            {
+                m_particles.flags[i] &= ~ParticleStore::SLEEPING;
+            }
+        }
+        if(still)
+            m_sleepingCount += end - begin;
+    }
+}
+
+void Simulation::wakeAll( )
+{
+    for(auto& obj : m_objects)
+    {
+        obj.isSleeping = false;
+        obj.stillTicks = 0;
+    }
+}
+
 void Simulation::ballGrabbedMovement( )
+{
+    for(std::size_t i = 0; i < m_particles.size(); ++i)
+    {
+        if(m_particles.isGrabbed(i))
+        {
+            m_particles.x[i] = m_mousePosView.x;
+            m_particles.y[i] = m_mousePosView.y;
+        }
+    }
+}
+
+void Simulation::updateGrabbedOutline( )
 {
     for(auto &obj : m_objects)
     {
@@ -641,7 +1317,6 @@ void Simulation::ballGrabbedMovement( )
             else
                 obj.outlineColor = sf::Color::White;
             obj.outlineThic = 1;
-            obj.currentPos = m_mousePosView;
         }
     }
 }
@@ -649,7 +1324,7 @@ void Simulation::ballGrabbedMovement( )
 void Simulation::demoSpawner( )
 {
     
-    sf::Vector2f spawnPos = {m_window->getSize().x * 0.5f, m_window->getSize().y * 0.25f};
+    sf::Vector2f spawnPos = {m_constraintWidth * 0.5f, m_constraintHeight * 0.25f};
     float spawnDelay = 0.05f;
     float spawnSpeed = 40;
     int minRad = 6;
@@ -675,78 +1350,265 @@ void Simulation::demoSpawner( )
 
 void Simulation::checkConstraints( )
 {
-    for(auto &obj : m_objects)
+    float right = static_cast<float>(m_constraintWidth) - 5;
+    float bottom = static_cast<float>(m_constraintHeight);
+    for(std::size_t i = 0; i < m_particles.size(); ++i)
     {
-        sf::Vector2f veloc = obj.currentPos - obj.oldPos;
-        if(obj.currentPos.x > m_constraintWidth - 5 - obj.radius)
-        {
-            obj.currentPos.x = m_constraintWidth - 5 - obj.radius;
-            //obj.oldPos.x = obj.currentPos.x + veloc.x * obj.friction;
-        }
-        if(obj.currentPos.x < obj.radius)
-        {
-            obj.currentPos.x = obj.radius;
-            // obj.oldPos.x = obj.currentPos.x + veloc.x * obj.friction;
-        }
-        if(obj.currentPos.y < obj.radius)
+        if(m_particles.isSleeping(i))
+            continue;
+        float radius = m_particles.radius[i];
+        float& x = m_particles.x[i];
+        float& y = m_particles.y[i];
+        if(x > right - radius)
+            x = right - radius;
+        if(x < radius)
+            x = radius;
+        if(y < radius)
+            y = radius;
+        if(y > bottom - radius)
+            y = bottom - radius;
+    }
+}
+
+void Simulation::checkCollisions( )
+{
+    switch(m_broadPhase)
+    {
+        case BroadPhase::ALL_PAIRS:
+            checkCollisionsAllPairs();
+            break;
+        case BroadPhase::UNIFORM_GRID:
+            checkCollisionsGrid();
+            break;
+        case BroadPhase::HIERARCHICAL_GRID:
+            checkCollisionsHierarchicalGrid();
+            break;
+        case BroadPhase::SWEEP_AND_PRUNE:
+            checkCollisionsSweepAndPrune();
+            break;
+        case BroadPhase::NEIGHBOUR_LIST:
+            checkCollisionsNeighbourList();
+            break;
+    }
+
+    mouseCollisionsBall();
+}
+
+void Simulation::checkCollisionsAllPairs( )
+{
+    for(std::size_t i = 0; i < m_particles.size(); ++i)
+    {
+        for(std::size_t j = i + 1; j < m_particles.size(); ++j)
         {
-            obj.currentPos.y = obj.radius;
-            // obj.oldPos.y = obj.currentPos.y + veloc.y * obj.friction;
+            solveCollision(i, j);
         }
-        if(obj.currentPos.y > m_constraintHeight - obj.radius)
+    }
+}
+
+void Simulation::checkCollisionsGrid( )
+{
+    // rebuilt every substep since the balls move between them
+    m_grid.build(m_particles, m_constraintWidth, m_constraintHeight);
+
+    if(m_threadPool.getThreadCount() > 1 && m_particles.size() >= MIN_PARALLEL_BALLS)
+    {
+        if(m_islandContacts)
+            checkCollisionsGridIslands();
+        else
+            checkCollisionsGridParallel();
+        return;
+    }
+
+    PairBlock block;
+    m_grid.forEachPair([this, &block](int i, int j){
+        narrowPhase(block, i, j);
+    });
+    flushNarrowPhase(block);
+}
+
+void Simulation::checkCollisionsGridParallel( )
+{
+    // the grid is split into stripes of columns, a stripe only moves balls in its own columns and the
+    // column either side, so with stripes at least 2 wide the even stripes can all run at once, then the odd ones
+    int columns = m_grid.getColumns();
+    int stripeCount = std::max(1, std::min(m_threadPool.getThreadCount() * 2, columns / 2));
+
+    for(int phase = 0; phase < 2; ++phase)
+    {
+        int phaseStripes = (stripeCount - phase + 1) / 2;
+        m_threadPool.run(phaseStripes, [this, phase, columns, stripeCount](int task){
+            int stripe = task * 2 + phase;
+            int colBegin = stripe * columns / stripeCount;
+            int colEnd = (stripe + 1) * columns / stripeCount;
+            // each stripe batches its own pairs so the blocks never mix balls from different stripes
+            PairBlock block;
+            m_grid.forEachPairInColumns(colBegin, colEnd, [this, &block](int i, int j){
+                narrowPhase(block, i, j);
+            });
+            flushNarrowPhase(block);
+        });
+    }
+}
+
+void Simulation::checkCollisionsGridIslands( )
+{
+    // only pairs that are touching now count as contacts, anything the solve pushes into contact waits for the
+    // next iteration or substep
+    m_contactPairs.clear();
+    m_grid.forEachPair([this](int i, int j){
+        if(m_particles.areBothSleeping(i, j))
+            return;
+        float axisX = m_particles.x[i] - m_particles.x[j];
+        float axisY = m_particles.y[i] - m_particles.y[j];
+        float minDist = m_particles.radius[i] + m_particles.radius[j];
+        if(axisX * axisX + axisY * axisY < minDist * minDist)
+            m_contactPairs.emplace_back(i, j);
+    });
+
+    // the stick islands joined up by the contacts, nothing in one of these touches anything in another
+    updateIslands();
+    m_contactIslands = m_islands;
+    for(auto& pair : m_contactPairs)
+        m_contactIslands.join(pair.first, pair.second);
+    m_contactIslands.group();
+
+    // counting sort of the contacts by island
+    int islandCount = m_contactIslands.getIslandCount();
+    std::vector<int> islandStart(islandCount + 1, 0);
+    for(auto& pair : m_contactPairs)
+        islandStart[m_contactIslands.getIsland(pair.first) + 1]++;
+    for(int k = 0; k < islandCount; ++k)
+        islandStart[k + 1] += islandStart[k];
+
+    m_islandPairs.resize(m_contactPairs.size());
+    std::vector<int> cursor(islandStart.begin(), islandStart.end() - 1);
+    for(auto& pair : m_contactPairs)
+        m_islandPairs[cursor[m_contactIslands.getIsland(pair.first)]++] = pair;
+
+    splitIntoTasks(islandStart, CONTACTS_PER_TASK, m_islandPairTasks);
+    int taskCount = static_cast<int>(m_islandPairTasks.size()) - 1;
+    m_threadPool.run(taskCount, [this](int task){
+        for(int p = m_islandPairTasks[task]; p < m_islandPairTasks[task + 1]; ++p)
+            solveCollision(m_islandPairs[p].first, m_islandPairs[p].second);
+    });
+}
+
+void Simulation::checkCollisionsHierarchicalGrid( )
+{
+    m_hierarchicalGrid.build(m_particles, m_constraintWidth, m_constraintHeight);
+    PairBlock block;
+    m_hierarchicalGrid.forEachPair([this, &block](int i, int j){
+        narrowPhase(block, i, j);
+    });
+    flushNarrowPhase(block);
+}
+
+void Simulation::checkCollisionsSweepAndPrune( )
+{
+    // the sorted order is kept from the last substep, so this only re-sorts what moved
+    m_sweepAndPrune.update(m_particles, m_topologyVersion);
+    PairBlock block;
+    m_sweepAndPrune.forEachPair([this, &block](int i, int j){
+        narrowPhase(block, i, j);
+    });
+    flushNarrowPhase(block);
+}
+
+void Simulation::checkCollisionsNeighbourList( )
+{
+    // most substeps reuse the lists from an earlier one, they only rebuild once something has moved far enough
+    m_neighbourList.update(m_particles, m_constraintWidth, m_constraintHeight, m_topologyVersion);
+    PairBlock block;
+    m_neighbourList.forEachPair([this, &block](int i, int j){
+        narrowPhase(block, i, j);
+    });
+    flushNarrowPhase(block);
+}
+
+void Simulation::narrowPhase( PairBlock& block, int i, int j )
+{
+    if(m_particles.areBothSleeping(i, j))
+        return;
+
+    if(!m_batchedNarrowPhase)
+    {
+        solveCollision(i, j);
+        return;
+    }
+
+    // the lanes are solved from the same positions, so a ball already in the block has to wait for the next one
+    for(int k = 0; k < block.count; ++k)
+    {
+        if(block.first[k] == i || block.first[k] == j || block.second[k] == i || block.second[k] == j)
         {
-            obj.currentPos.y = m_constraintHeight - obj.radius;
-            // obj.oldPos.y = obj.currentPos.y + veloc.y * obj.friction;
+            flushNarrowPhase(block);
+            break;
         }
     }
+
+    block.first[block.count] = i;
+    block.second[block.count] = j;
+    block.count++;
+    if(block.count == PairBlock::SIZE)
+        flushNarrowPhase(block);
 }
 
-void Simulation::checkCollisions( )
+void Simulation::flushNarrowPhase( PairBlock& block )
 {
+    if(block.count > 0)
+        SimdKernels::solveCollisionBlock(m_particles, block, m_simdLevel, m_strictMath);
+    block.count = 0;
+}
 
-    for(std::size_t i = 0; i < m_objects.size(); ++i)
+void Simulation::solveCollision( int i, int j )
+{
+    if(m_particles.areBothSleeping(i, j))
+        return;
+
+    float axisX = m_particles.x[i] - m_particles.x[j];
+    float axisY = m_particles.y[i] - m_particles.y[j];
+    float distanceBtw = sqrt(axisX * axisX + axisY * axisY);
+    float minAllowedDist = m_particles.radius[i] + m_particles.radius[j];
+    if(distanceBtw < minAllowedDist)
     {
-        Object& obj1 = m_objects[i];
-        for(std::size_t j = i + 1; j < m_objects.size(); ++j)
+        float moveAmount = minAllowedDist - distanceBtw;
+        float percentage = (moveAmount / distanceBtw) * 0.5;
+        float offsetX = axisX * percentage;
+        float offsetY = axisY * percentage;
+
+        // one of them is awake, whichever is asleep is only woken if it's pushed hard enough
+        if(!m_particles.isPinned(i) && m_particles.wakeByPush(i, offsetX, offsetY))
         {
-            Object& obj2 = m_objects[j];
-            sf::Vector2f axis = obj1.currentPos - obj2.currentPos;
-            float distanceBtw = sqrt(axis.x * axis.x + axis.y * axis.y);
-            float minAllowedDist = obj1.radius + obj2.radius;
-            if(distanceBtw < minAllowedDist)
-            {
-                float moveAmount = minAllowedDist - distanceBtw;
-                float percentage = (moveAmount / distanceBtw) * 0.5;
-                sf::Vector2f offsetAmount = axis * percentage;
-
-                if(!obj1.isPinned)
-                    obj1.currentPos += offsetAmount;
-                if(!obj2.isPinned)
-                    obj2.currentPos -= offsetAmount;
-            }
+            m_particles.x[i] += offsetX;
+            m_particles.y[i] += offsetY;
+        }
+        if(!m_particles.isPinned(j) && m_particles.wakeByPush(j, offsetX, offsetY))
+        {
+            m_particles.x[j] -= offsetX;
+            m_particles.y[j] -= offsetY;
         }
     }
-
-    mouseCollisionsBall();
 }
 
 void Simulation::mouseCollisionsBall( )
 {
     if(m_mouseColActive)
     {
-        for(auto &obj : m_objects)
+        for(std::size_t i = 0; i < m_particles.size(); ++i)
         {
-            sf::Vector2f axis = m_mousePosView - obj.currentPos;
-            float dist = sqrt(axis.x * axis.x + axis.y * axis.y);
-            float minDist = m_mouseColRad + obj.radius;
+            float axisX = m_mousePosView.x - m_particles.x[i];
+            float axisY = m_mousePosView.y - m_particles.y[i];
+            float dist = sqrt(axisX * axisX + axisY * axisY);
+            float minDist = m_mouseColRad + m_particles.radius[i];
             if(dist < minDist)
             {
-                if(!obj.isPinned)
+                m_particles.wake(i);
+                if(!m_particles.isPinned(i))
                 {
                     float moveAmount = minDist - dist;
                     float perc = (moveAmount / dist) * 0.5;
-                    sf::Vector2f off = axis * perc;
-                    obj.currentPos -= off;
+                    m_particles.x[i] -= axisX * perc;
+                    m_particles.y[i] -= axisY * perc;
                 }
             }
 
@@ -756,11 +1618,8 @@ void Simulation::mouseCollisionsBall( )
 
 void Simulation::updateObjects( float subDeltaTime )
 {
-    for( auto &obj : m_objects)
-    {
-        if(!obj.isPinned)
-            obj.update(subDeltaTime);
-    }
+    // same verlet step as Object::update
+    SimdKernels::integrate(m_particles, subDeltaTime, m_simdLevel, !m_strictMath);
 }
 
 void Simulation::applyGravityToObjects( )
@@ -769,35 +1628,127 @@ void Simulation::applyGravityToObjects( )
     
     if(m_gravityActive)
     {
-        for(auto &obj : m_objects)
+        for(std::size_t i = 0; i < m_particles.size(); ++i)
         {
-            obj.accelerate( obj.mass * GRAVITY);
+            // sleeping objects aren't integrated, so the acceleration would only pile up
+            if(m_particles.isSleeping(i))
+                continue;
+            m_particles.accX[i] += m_particles.mass[i] * GRAVITY.x;
+            m_particles.accY[i] += m_particles.mass[i] * GRAVITY.y;
         }
 
     }
 }
 
 
+void Simulation::publishSnapshot( )
+{
+    // the write buffer still has a frame from a while ago in it, everything gets overwritten
+    RenderSnapshot& snapshot = m_snapshots.getWriteBuffer();
+
+    snapshot.balls.resize(m_objects.size());
+    for(std::size_t i = 0; i < m_objects.size(); ++i)
+    {
+        Object& obj = m_objects[i];
+        snapshot.balls[i] = { obj.previousPos, obj.currentPos, obj.radius, obj.color, obj.outlineColor, obj.outlineThic, obj.isPinned };
+    }
+
+    // the compiled sticks already have the ball indices, so there's no looking up ids
+    if(!m_sticksCompiled || m_compiledSticksVersion != m_topologyVersion)
+        compileSticks();
+    snapshot.sticks.resize(m_compiledSticks.size());
+    for(std::size_t i = 0; i < m_compiledSticks.size(); ++i)
+        snapshot.sticks[i] = { m_compiledSticks[i].index1, m_compiledSticks[i].index2 };
+
+    snapshot.bluePrintSticks = m_stickMaker.bluePrintSticks;
+    snapshot.showBluePrints = !m_stickMaker.finishedStick && !m_stickMaker.bluePrintSticks.empty();
+
+    snapshot.mousePos = m_mousePosView;
+    snapshot.mouseColRadius = m_mouseColRad;
+    snapshot.showMouseCollider = m_buildModeActive || m_mouseColActive;
+    if(m_mouseColActive)
+        snapshot.mouseColColor = sf::Color::Red;
+    else if(m_newBallPin)
+        snapshot.mouseColColor = sf::Color::Green;
+    else
+        snapshot.mouseColColor = sf::Color(0, 128, 255);
+
+    snapshot.buildModeActive = m_buildModeActive;
+    snapshot.stickFinished = m_stickMaker.finishedStick;
+
+    snapshot.debugText = m_debugString;
+
+    snapshot.fixedTimestep = m_fixedTimestep;
+    snapshot.accumulator = m_accumulator;
+    snapshot.tickTime = 1.f / m_tickRate;
+    snapshot.publishedAt = std::chrono::steady_clock::now();
+
+    m_snapshots.publish();
+}
+
+const RenderSnapshot& Simulation::getSnapshot( )
+{
+    m_snapshots.update();
+    return m_snapshots.getReadBuffer();
+}
+
 // RENDERING
+float Simulation::getRenderAlpha( const RenderSnapshot& snapshot )
+{
+    if(!snapshot.fixedTimestep)
+        return 1.f;
+
+    // the snapshot was published part way into a tick, and time has gone on since then
+    float sincePublished = std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot.publishedAt).count();
+    return std::min((snapshot.accumulator + sincePublished) / snapshot.tickTime, 1.f);
+}
+
 void Simulation::render( sf::RenderTarget &target )
 {
+    // if the simulation hasn't finished a frame since last time, the last one is drawn again
+    const RenderSnapshot& snapshot = getSnapshot();
+    m_renderAlpha = getRenderAlpha(snapshot);
 
     renderSticks(target);
 
+    if(m_renderMode == RenderMode::TEXTURED_QUADS)
+        renderBallQuads(target, snapshot);
+    else if(m_renderMode == RenderMode::TRIANGLES)
+        renderBallTriangles(target, snapshot);
+    else
+        renderBallShapes(target, snapshot);
+
+    renderBluePrints(target);
+
+
+    if(snapshot.showMouseCollider)
+    {
+        float newRad = snapshot.mouseColRadius - m_mouseColShape.getOutlineThickness();
+        m_mouseColShape.setRadius(newRad);
+        m_mouseColShape.setOrigin(newRad, newRad);
+        m_mouseColShape.setPosition(snapshot.mousePos);
+        m_mouseColShape.setOutlineColor(snapshot.mouseColColor);
+
+        target.draw(m_mouseColShape);
+    }
+}
+
+void Simulation::renderBallShapes( sf::RenderTarget& target, const RenderSnapshot& snapshot )
+{
     sf::CircleShape circleS;
     circleS.setPointCount(Simulation::s_ballPointCount);
     sf::CircleShape pinShape;
-    for(auto &obj : m_objects)
+    for(auto &ball : snapshot.balls)
     {
-        circleS.setRadius(obj.radius);
-        circleS.setOrigin(obj.radius, obj.radius);
-        circleS.setFillColor(obj.color);
-        circleS.setPosition(obj.currentPos);
-        circleS.setOutlineColor(obj.outlineColor);
-        circleS.setOutlineThickness(obj.outlineThic);
+        circleS.setRadius(ball.radius);
+        circleS.setOrigin(ball.radius, ball.radius);
+        circleS.setFillColor(ball.color);
+        circleS.setPosition(getRenderPosition(ball));
+        circleS.setOutlineColor(ball.outlineColor);
+        circleS.setOutlineThickness(ball.outlineThic);
         target.draw(circleS);
         
-        if(obj.isPinned)
+        if(ball.isPinned)
         {
             pinShape.setFillColor(sf::Color::Red);
             pinShape.setOutlineThickness(1);
@@ -810,80 +1761,234 @@ void Simulation::render( sf::RenderTarget &target )
         }
 
     }
+}
 
-    renderBluePrints(target);
+void Simulation::renderBallTriangles( sf::RenderTarget& target, const RenderSnapshot& snapshot )
+{
+    int circleVertices = s_ballPointCount * 3;
+    int ringVertices = s_ballPointCount * 6;
 
+    std::size_t vertexCount = 0;
+    for(auto &ball : snapshot.balls)
+    {
+        vertexCount += circleVertices;
+        if(ball.outlineThic != 0)
+            vertexCount += ringVertices;
+        if(ball.isPinned)
+            vertexCount += circleVertices + ringVertices;
+    }
+    m_ballVertices.resize(vertexCount);
 
-    if(m_buildModeActive || m_mouseColActive)
+    // same order the shapes would be drawn in, so overlapping balls still cover each other the same way
+    std::size_t vertex = 0;
+    for(auto &ball : snapshot.balls)
     {
-        float newRad = m_mouseColRad - m_mouseColShape.getOutlineThickness();
-        m_mouseColShape.setRadius(newRad);
-        m_mouseColShape.setOrigin(newRad, newRad);
-        m_mouseColShape.setPosition(m_mousePosView);
+        sf::Vector2f position = getRenderPosition(ball);
+        addCircleTriangles(vertex, position, ball.radius, ball.color);
+        if(ball.outlineThic != 0)
+            addRingTriangles(vertex, position, ball.radius, ball.outlineThic, ball.outlineColor);
 
-        if(m_mouseColActive)
-            m_mouseColShape.setOutlineColor(sf::Color::Red);
-        else if(m_buildModeActive)
+        if(ball.isPinned)
         {
-            if(m_newBallPin)
-                m_mouseColShape.setOutlineColor(sf::Color::Green);
-            else
-                m_mouseColShape.setOutlineColor(sf::Color(0, 128, 255));
+            float pinRadius = ball.radius * 0.2f - 1.f;
+            addCircleTriangles(vertex, position, pinRadius, sf::Color::Red);
+            addRingTriangles(vertex, position, pinRadius, 1.f, sf::Color::Black);
         }
+    }
 
+    target.draw(m_ballVertices);
+}
 
-        target.draw(m_mouseColShape);
+void Simulation::addCircleTriangles( std::size_t& vertex, sf::Vector2f center, float radius, sf::Color color )
+{
+    for(int i = 0; i < s_ballPointCount; ++i)
+    {
+        const sf::Vector2f& point1 = m_circlePoints[i];
+        const sf::Vector2f& point2 = m_circlePoints[(i + 1) % s_ballPointCount];
+        m_ballVertices[vertex++] = sf::Vertex(center, color);
+        m_ballVertices[vertex++] = sf::Vertex(center + point1 * radius, color);
+        m_ballVertices[vertex++] = sf::Vertex(center + point2 * radius, color);
     }
 }
 
-void Simulation::renderSticks( sf::RenderTarget &target )
+void Simulation::addRingTriangles( std::size_t& vertex, sf::Vector2f center, float radius, float thickness, sf::Color color )
+{
+    // like sf::Shape the outline sits outside the radius, a negative thickness puts it inside
+    float outerRadius = radius + thickness;
+    for(int i = 0; i < s_ballPointCount; ++i)
+    {
+        const sf::Vector2f& point1 = m_circlePoints[i];
+        const sf::Vector2f& point2 = m_circlePoints[(i + 1) % s_ballPointCount];
+        sf::Vertex inner1(center + point1 * radius, color);
+        sf::Vertex inner2(center + point2 * radius, color);
+        sf::Vertex outer1(center + point1 * outerRadius, color);
+        sf::Vertex outer2(center + point2 * outerRadius, color);
+        m_ballVertices[vertex++] = inner1;
+        m_ballVertices[vertex++] = outer1;
+        m_ballVertices[vertex++] = outer2;
+        m_ballVertices[vertex++] = inner1;
+        m_ballVertices[vertex++] = outer2;
+        m_ballVertices[vertex++] = inner2;
+    }
+}
+
+void Simulation::renderBallQuads( sf::RenderTarget& target, const RenderSnapshot& snapshot )
+{
+    if(m_circleTexture.getSize().x == 0)
+        initCircleTexture();
+
+    std::size_t vertexCount = 0;
+    for(auto &ball : snapshot.balls)
+    {
+        vertexCount += ball.outlineThic > 0 ? 8 : 4;
+        if(ball.isPinned)
+            vertexCount += 8;
+    }
+    m_ballQuads.resize(vertexCount);
+
+    // an outline is a slightly bigger circle drawn just before the one it goes round
+    std::size_t vertex = 0;
+    for(auto &ball : snapshot.balls)
+    {
+        sf::Vector2f position = getRenderPosition(ball);
+        if(ball.outlineThic > 0)
+            addCircleQuad(vertex, position, ball.radius + ball.outlineThic, ball.outlineColor);
+        addCircleQuad(vertex, position, ball.radius, ball.color);
+
+        if(ball.isPinned)
+        {
+            addCircleQuad(vertex, position, ball.radius * 0.2f, sf::Color::Black);
+            addCircleQuad(vertex, position, ball.radius * 0.2f - 1.f, sf::Color::Red);
+        }
+    }
+
+    sf::RenderStates states;
+    states.texture = &m_circleTexture;
+    target.draw(m_ballQuads, states);
+}
+
+void Simulation::addCircleQuad( std::size_t& vertex, sf::Vector2f center, float radius, sf::Color color )
+{
+    // the circle in the texture stops a texel short of the edge, so the quad is that much bigger than the ball
+    float size = s_circleTextureSize;
+    float half = radius * size / (size - 2.f);
+    m_ballQuads[vertex++] = sf::Vertex(center + sf::Vector2f(-half, -half), color, sf::Vector2f(0.f, 0.f));
+    m_ballQuads[vertex++] = sf::Vertex(center + sf::Vector2f(half, -half), color, sf::Vector2f(size, 0.f));
+    m_ballQuads[vertex++] = sf::Vertex(center + sf::Vector2f(half, half), color, sf::Vector2f(size, size));
+    m_ballQuads[vertex++] = sf::Vertex(center + sf::Vector2f(-half, half), color, sf::Vector2f(0.f, size));
+}
+
+void Simulation::initCircleTexture( )
 {
-    for(auto &stick : m_sticks)
+    sf::Image image;
+    image.create(s_circleTextureSize, s_circleTextureSize, sf::Color::Transparent);
+
+    // the alpha fades out over one texel at the edge, mipmaps keep that smooth when the ball is drawn small
+    float center = s_circleTextureSize * 0.5f;
+    float radius = center - 1.f;
+    for(int y = 0; y < s_circleTextureSize; ++y)
     {
-        sf::Vertex lines[2];
-        lines[0].position = m_objects.getById(stick.obj1ID).currentPos;
-        lines[0].color = m_objects.getById(stick.obj1ID).color;
-        lines[1].position = m_objects.getById(stick.obj2ID).currentPos;
-        lines[1].color = m_objects.getById(stick.obj2ID).color;
+        for(int x = 0; x < s_circleTextureSize; ++x)
+        {
+            float dx = x + 0.5f - center;
+            float dy = y + 0.5f - center;
+            float coverage = std::clamp(radius - std::sqrt(dx * dx + dy * dy) + 0.5f, 0.f, 1.f);
+            image.setPixel(x, y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(coverage * 255.f)));
+        }
+    }
+
+    m_circleTexture.loadFromImage(image);
+    m_circleTexture.setSmooth(true);
+    m_circleTexture.generateMipmap();
+}
+
+void Simulation::setRenderMode( RenderMode mode )
+{
+    m_renderMode = mode;
+}
 
-        target.draw(lines, 2, sf::LineStrip);
+void Simulation::setStickVertexBuffer( bool enabled )
+{
+    m_stickVertexBuffer = enabled;
+}
 
+const RenderMode Simulation::getRenderMode( ) const
+{
+    return m_renderMode;
+}
+
+void Simulation::renderSticks( sf::RenderTarget &target )
+{
+    const RenderSnapshot& snapshot = m_snapshots.getReadBuffer();
+    std::size_t vertexCount = snapshot.sticks.size() * 2;
+    if(vertexCount == 0)
+        return;
+
+    m_stickVertices.resize(vertexCount);
+    std::size_t vertex = 0;
+    for(auto &stick : snapshot.sticks)
+    {
+        const RenderSnapshot::Ball& ball1 = snapshot.balls[stick.ball1];
+        const RenderSnapshot::Ball& ball2 = snapshot.balls[stick.ball2];
+        m_stickVertices[vertex++] = sf::Vertex(getRenderPosition(ball1), ball1.color);
+        m_stickVertices[vertex++] = sf::Vertex(getRenderPosition(ball2), ball2.color);
+    }
+
+    if(m_stickVertexBuffer && sf::VertexBuffer::isAvailable())
+    {
+        // only grows, a frame with fewer sticks just draws the front of it
+        if(m_stickBuffer.getVertexCount() < vertexCount)
+            m_stickBuffer.create(vertexCount);
+        m_stickBuffer.update(&m_stickVertices[0], vertexCount, 0);
+        target.draw(m_stickBuffer, 0, vertexCount);
+    }
+    else{
+        target.draw(m_stickVertices);
     }
 }
 
+const sf::Vector2f Simulation::getRenderPosition( const RenderSnapshot::Ball& ball ) const
+{
+    // draws the state one tick behind the physics, so a frame between two ticks never has to guess ahead
+    return ball.previousPos + (ball.currentPos - ball.previousPos) * m_renderAlpha;
+}
+
 void Simulation::renderUI( sf::RenderTarget &target )
 {
+    m_debugText.setString(m_snapshots.getReadBuffer().debugText);
     target.draw(m_debugText);
 }
 
 void Simulation::renderBluePrints( sf::RenderTarget &target )
 {
-    if(!m_stickMaker.finishedStick)
+    const RenderSnapshot& snapshot = m_snapshots.getReadBuffer();
+    const std::vector<Builder::BluePrintStick>& bluePrintSticks = snapshot.bluePrintSticks;
+    if(snapshot.showBluePrints)
     {
         sf::CircleShape bpPinShape;
-        for(std::size_t i = 0; i < m_stickMaker.bluePrintSticks.size(); ++i)
+        for(std::size_t i = 0; i < bluePrintSticks.size(); ++i)
         {
-            target.draw(m_stickMaker.bluePrintSticks[i].shape);
-            if(m_stickMaker.bluePrintSticks[i].isPinned)
+            target.draw(bluePrintSticks[i].shape);
+            if(bluePrintSticks[i].isPinned)
             {
                 bpPinShape.setFillColor(sf::Color::Red);
                 bpPinShape.setOutlineThickness(1);
                 bpPinShape.setOutlineColor(sf::Color::Black);
-                bpPinShape.setRadius((m_stickMaker.bluePrintSticks[i].shape.getRadius() * 0.2) - bpPinShape.getOutlineThickness());
+                bpPinShape.setRadius((bluePrintSticks[i].shape.getRadius() * 0.2) - bpPinShape.getOutlineThickness());
                 bpPinShape.setOrigin(bpPinShape.getRadius(), bpPinShape.getRadius());
-                bpPinShape.setPosition(m_stickMaker.bluePrintSticks[i].shape.getPosition());
+                bpPinShape.setPosition(bluePrintSticks[i].shape.getPosition());
 
                 target.draw(bpPinShape);
             }
 
-            if(i < m_stickMaker.bluePrintSticks.size() - 1)
+            if(i < bluePrintSticks.size() - 1)
             {
                 // draws the lines of the sticks blue prints
                 sf::Vertex lines[2];
-                lines[0].position = m_stickMaker.bluePrintSticks[i].shape.getPosition();
-                lines[0].color = m_stickMaker.bluePrintSticks[i].shape.getFillColor();
-                lines[1].position = m_stickMaker.bluePrintSticks[i+1].shape.getPosition();
-                lines[1].color = m_stickMaker.bluePrintSticks[i+1].shape.getFillColor();
+                lines[0].position = bluePrintSticks[i].shape.getPosition();
+                lines[0].color = bluePrintSticks[i].shape.getFillColor();
+                lines[1].position = bluePrintSticks[i+1].shape.getPosition();
+                lines[1].color = bluePrintSticks[i+1].shape.getFillColor();
                 target.draw(lines, 2, sf::LineStrip);
             }
 
@@ -892,10 +1997,10 @@ void Simulation::renderBluePrints( sf::RenderTarget &target )
 
         // visually show how the stick will look with the mouse
         sf::Vertex lineToMouse[2];
-        int lastIndex = m_stickMaker.bluePrintSticks.size() - 1;
-        lineToMouse[0].position = m_stickMaker.bluePrintSticks[lastIndex].shape.getPosition();
-        lineToMouse[0].color = m_stickMaker.bluePrintSticks[lastIndex].shape.getFillColor();
-        lineToMouse[1].position = m_mousePosView;
+        int lastIndex = bluePrintSticks.size() - 1;
+        lineToMouse[0].position = bluePrintSticks[lastIndex].shape.getPosition();
+        lineToMouse[0].color = bluePrintSticks[lastIndex].shape.getFillColor();
+        lineToMouse[1].position = snapshot.mousePos;
         lineToMouse[1].color = sf::Color::White;
         target.draw(lineToMouse, 2, sf::LineStrip);
 
@@ -0,0 +1,68 @@
+#include "../include/StickColouring.h"
+#include <algorithm>
+
+using namespace pe;
+
+void StickColouring::build( const std::vector<CompiledStick>& sticks, std::size_t objectCount )
+{
+    m_usedColours.assign(objectCount, 0);
+    m_stickColour.resize(sticks.size());
+
+    // every stick takes the lowest colour neither of its objects has used yet
+    int colourCount = 0;
+    for(std::size_t s = 0; s < sticks.size(); ++s)
+    {
+        const CompiledStick& stick = sticks[s];
+        std::uint64_t used = m_usedColours[stick.index1] | m_usedColours[stick.index2];
+
+        int colour = 0;
+        while(colour < s_maxColours && (used & (std::uint64_t(1) << colour)))
+            ++colour;
+
+        if(colour < s_maxColours)
+        {
+            m_usedColours[stick.index1] |= std::uint64_t(1) << colour;
+            m_usedColours[stick.index2] |= std::uint64_t(1) << colour;
+        }
+
+        m_stickColour[s] = colour;
+        colourCount = std::max(colourCount, colour + 1);
+    }
+
+    // counting sort of the sticks by colour
+    m_colourStart.assign(colourCount + 1, 0);
+    for(int colour : m_stickColour)
+        m_colourStart[colour + 1]++;
+    for(int c = 0; c < colourCount; ++c)
+        m_colourStart[c + 1] += m_colourStart[c];
+
+    std::vector<int> cursor(m_colourStart.begin(), m_colourStart.end() - 1);
+    m_sticks.resize(sticks.size());
+    for(std::size_t s = 0; s < sticks.size(); ++s)
+        m_sticks[cursor[m_stickColour[s]]++] = sticks[s];
+}
+
+const int StickColouring::getColourCount( ) const
+{
+    return static_cast<int>(m_colourStart.size()) - 1;
+}
+
+const bool StickColouring::isSequentialColour( int colour ) const
+{
+    return colour >= s_maxColours;
+}
+
+std::vector<CompiledStick>& StickColouring::getSticks( )
+{
+    return m_sticks;
+}
+
+const int StickColouring::getColourBegin( int colour ) const
+{
+    return m_colourStart[colour];
+}
+
+const int StickColouring::getColourEnd( int colour ) const
+{
+    return m_colourStart[colour + 1];
+}
@@ -0,0 +1,59 @@
+#include "../include/SweepAndPrune.h"
+#include <algorithm>
+
+using namespace pe;
+
+void SweepAndPrune::update( const ParticleStore& particles, unsigned int topologyVersion )
+{
+    // indices shift when objects are deleted so the old order can't be reused
+    if(!m_built || topologyVersion != m_topologyVersion || m_intervals.size() != particles.size())
+    {
+        rebuild(particles);
+        m_topologyVersion = topologyVersion;
+        m_built = true;
+        return;
+    }
+
+    refreshBounds(particles);
+    insertionSort();
+}
+
+void SweepAndPrune::rebuild( const ParticleStore& particles )
+{
+    m_intervals.resize(particles.size());
+    for(std::size_t i = 0; i < particles.size(); ++i)
+        m_intervals[i].index = static_cast<int>(i);
+
+    refreshBounds(particles);
+    std::sort(m_intervals.begin(), m_intervals.end(), [](const Interval& a, const Interval& b){
+        return a.minX < b.minX;
+    });
+}
+
+void SweepAndPrune::refreshBounds( const ParticleStore& particles )
+{
+    for(auto& interval : m_intervals)
+    {
+        int i = interval.index;
+        interval.minX = particles.x[i] - particles.radius[i];
+        interval.maxX = particles.x[i] + particles.radius[i];
+        interval.minY = particles.y[i] - particles.radius[i];
+        interval.maxY = particles.y[i] + particles.radius[i];
+    }
+}
+
+void SweepAndPrune::insertionSort( )
+{
+    // insertion sort, almost free when the order hasn't changed since last time
+    for(std::size_t i = 1; i < m_intervals.size(); ++i)
+    {
+        Interval current = m_intervals[i];
+        std::size_t j = i;
+        while(j > 0 && m_intervals[j - 1].minX > current.minX)
+        {
+            m_intervals[j] = m_intervals[j - 1];
+            --j;
+        }
+        m_intervals[j] = current;
+    }
+}
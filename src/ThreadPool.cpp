@@ -0,0 +1,101 @@
+#include "../include/ThreadPool.h"
+
+using namespace pe;
+
+ThreadPool::ThreadPool( )
+{
+}
+
+ThreadPool::~ThreadPool( )
+{
+    stopWorkers();
+}
+
+void ThreadPool::setThreadCount( int count )
+{
+    stopWorkers();
+
+    m_stopping = false;
+    // the calling thread does work too, so it only needs count - 1 workers
+    for(int i = 1; i < count; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, m_generation);
+}
+
+const int ThreadPool::getThreadCount( ) const
+{
+    return static_cast<int>(m_workers.size()) + 1;
+}
+
+void ThreadPool::stopWorkers( )
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCondition.notify_all();
+
+    for(auto& worker : m_workers)
+    {
+        if(worker.joinable())
+            worker.join();
+    }
+    m_workers.clear();
+}
+
+void ThreadPool::runTasks( )
+{
+    int index = m_nextTask.fetch_add(1);
+    while(index < m_taskCount)
+    {
+        (*m_task)(index);
+        index = m_nextTask.fetch_add(1);
+    }
+}
+
+void ThreadPool::workerLoop( unsigned int seenGeneration )
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCondition.wait(lock, [&]{ return m_stopping || m_generation != seenGeneration; });
+            if(m_stopping)
+                return;
+            seenGeneration = m_generation;
+        }
+
+        runTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busyWorkers--;
+        }
+        m_doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::run( int taskCount, const std::function<void(int)>& task )
+{
+    if(m_workers.empty() || taskCount <= 1)
+    {
+        for(int i = 0; i < taskCount; ++i)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_busyWorkers = static_cast<int>(m_workers.size());
+        m_generation++;
+    }
+    m_workCondition.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [&]{ return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
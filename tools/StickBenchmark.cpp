@@ -0,0 +1,100 @@
+#include <iostream>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "SFML/System/Clock.hpp"
+#include "../include/Simulation.h"
+
+// hangs the same cloth under every stick solver, times the ticks and prints how far the sticks ended up from
+// their lengths, build with build/compile_benchmark.sh
+
+namespace {
+
+    const int CLOTH_WIDTH = 120;
+    const int CLOTH_HEIGHT = 80;
+    const float SPACING = 8.f;
+    const float RADIUS = 3.f;
+    const int WARMUP_TICKS = 30;
+    const int TICKS = 240;
+
+    void buildCloth( pe::Simulation& sim )
+    {
+        std::vector<int> ids(CLOTH_WIDTH * CLOTH_HEIGHT);
+        for(int y = 0; y < CLOTH_HEIGHT; ++y)
+        {
+            for(int x = 0; x < CLOTH_WIDTH; ++x)
+            {
+                // the top row is pinned every few balls so the cloth sags between them
+                bool pinned = y == 0 && x % 8 == 0;
+                Object& obj = sim.addNewObject(sf::Vector2f(50.f + x * SPACING, 50.f + y * SPACING), RADIUS, pinned);
+                ids[y * CLOTH_WIDTH + x] = obj.ID;
+            }
+        }
+
+        for(int y = 0; y < CLOTH_HEIGHT; ++y)
+        {
+            for(int x = 0; x < CLOTH_WIDTH; ++x)
+            {
+                int id = ids[y * CLOTH_WIDTH + x];
+                if(x + 1 < CLOTH_WIDTH)
+                    sim.addNewStick(id, ids[y * CLOTH_WIDTH + x + 1], SPACING);
+                if(y + 1 < CLOTH_HEIGHT)
+                    sim.addNewStick(id, ids[(y + 1) * CLOTH_WIDTH + x], SPACING);
+            }
+        }
+    }
+
+    // root mean square of how far each stick is from its length
+    float getStickError( pe::Simulation& sim )
+    {
+        IDVector<Object>& objects = sim.getObjects();
+        double errorSq = 0.0;
+        int count = 0;
+        for(auto& stick : sim.getSticks())
+        {
+            sf::Vector2f axis = objects.getById(stick.obj2ID).currentPos - objects.getById(stick.obj1ID).currentPos;
+            float error = std::sqrt(axis.x * axis.x + axis.y * axis.y) - stick.length;
+            errorSq += error * error;
+            count++;
+        }
+        return count > 0 ? static_cast<float>(std::sqrt(errorSq / count)) : 0.f;
+    }
+
+    void runSolver( pe::StickSolver solver, const char* name )
+    {
+        pe::Simulation sim;
+        sim.setConstraintDimensions(1200, 1000);
+        sim.setSubSteps(12);
+        sim.setTickRate(60.f);
+        sim.setThreadCount(std::thread::hardware_concurrency());
+        // a sleeping cloth would skip the very work being timed
+        sim.setSleeping(false, 0.f, 1);
+        sim.setStickSolver(solver);
+        buildCloth(sim);
+
+        // the simulation only moves things while it thinks the window has focus
+        pe::FrameInput input;
+        input.mousePos = sf::Vector2f(-1000.f, -1000.f);
+        input.hasFocus = true;
+        sim.setFrameInput(input);
+
+        sim.advance(WARMUP_TICKS);
+        sf::Clock clock;
+        sim.advance(TICKS);
+        float milliseconds = clock.getElapsedTime().asMicroseconds() / 1000.f;
+
+        std::cout << "    " << name << ": " << milliseconds / TICKS << "ms PER TICK, ERROR " << getStickError(sim) << '\n';
+    }
+
+};
+
+int main()
+{
+    std::cout << "STICK BENCHMARK: " << CLOTH_WIDTH * CLOTH_HEIGHT << " BALLS, " << TICKS << " TICKS" << '\n';
+    runSolver(pe::StickSolver::SEQUENTIAL, "SEQUENTIAL");
+    runSolver(pe::StickSolver::COLOURED_PARALLEL, "COLOURED PARALLEL");
+    runSolver(pe::StickSolver::JACOBI, "JACOBI");
+    runSolver(pe::StickSolver::ISLAND_PARALLEL, "ISLAND PARALLEL");
+    return 0;
+}